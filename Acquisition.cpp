@@ -0,0 +1,166 @@
+/*
+ * Acquisition.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <pthread.h>
+#include <sched.h>
+#include "Acquisition.h"
+#include "Metrics.h"
+
+namespace PowerMonitor
+{
+
+Acquisition::Acquisition(GalileoGen2Adc& adc, const std::vector<unsigned int>& channels,
+        unsigned int blockSize, unsigned int queueBlocks, int priority) :
+        _adc(adc),
+        _channels(channels),
+        _ring(queueBlocks, SampleBlock(channels.size(), blockSize)),
+        _priority(priority),
+        _running(false),
+        _overruns(0),
+        _maxDepth(0),
+        _failed(false)
+{
+    if (sem_init(&_ready, 0, 0) < 0)
+    {
+        throw std::runtime_error("Could not create semaphore: " + std::string(strerror(errno)));
+    }
+    // Conversion parameters do not change, store them in every block once.
+    for (size_t i = 0; i < _ring.capacity(); ++i)
+    {
+        SampleBlock* block = _ring.acquireWrite();
+        for (unsigned int c = 0; c < _channels.size(); ++c)
+        {
+            block->scale[c] = _adc.scale(_channels[c]);
+            block->offset[c] = _adc.offset(_channels[c]);
+        }
+        _ring.commitWrite();
+    }
+    while (_ring.acquireRead())
+        _ring.releaseRead();
+}
+
+Acquisition::~Acquisition()
+{
+    stop();
+    sem_destroy(&_ready);
+}
+
+void* Acquisition::operator new(size_t size)
+{
+    void* p;
+    if (posix_memalign(&p, alignof(Acquisition), size) != 0)
+        throw std::bad_alloc();
+    return p;
+}
+
+void Acquisition::operator delete(void* p)
+{
+    free(p);
+}
+
+void Acquisition::start()
+{
+    if (_running)
+        return;
+    _running = true;
+    _thread = std::thread(&Acquisition::_run, this);
+    if (_priority > 0)
+    {
+        struct sched_param param;
+        param.sched_priority = _priority;
+        int ret = pthread_setschedparam(_thread.native_handle(), SCHED_FIFO, &param);
+        if (ret != 0)
+        {
+            stop();
+            throw std::runtime_error("Could not set real-time priority: " + std::string(strerror(ret)));
+        }
+    }
+}
+
+void Acquisition::stop()
+{
+    _running = false;
+    if (_thread.joinable())
+        _thread.join();
+}
+
+const SampleBlock* Acquisition::next(unsigned int timeoutMs)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += timeoutMs / 1000;
+    ts.tv_nsec += (timeoutMs % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    if (sem_timedwait(&_ready, &ts) < 0)
+    {
+        if (_failed.load(std::memory_order_acquire))
+            std::rethrow_exception(_error);
+        return nullptr;
+    }
+    if (_failed.load(std::memory_order_acquire) && _ring.size() == 0)
+        std::rethrow_exception(_error);
+    return _ring.acquireRead();
+}
+
+void Acquisition::release()
+{
+    _ring.releaseRead();
+}
+
+void Acquisition::_run()
+{
+    std::vector<int16_t*> out(_channels.size());
+    MetricsSampler sampler;
+    try
+    {
+        while (_running.load(std::memory_order_relaxed))
+        {
+            StageTimer timer(StageRefill, sampler(_adc.size()));
+            _adc.refill();
+            timer.stop();
+            SampleBlock* block = _ring.acquireWrite();
+            if (block == nullptr)
+            {
+                _overruns.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (_adc.size() > block->capacity)
+                throw std::runtime_error("ADC buffer larger than block size.");
+            timer.next(StageRead);
+            for (unsigned int c = 0; c < _channels.size(); ++c)
+                out[c] = block->channel(c);
+            block->size = _adc.read(_channels.data(), _channels.size(), out.data());
+            timer.stop();
+            block->timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+            _ring.commitWrite();
+            size_t depth = _ring.size();
+            if (depth > _maxDepth.load(std::memory_order_relaxed))
+                _maxDepth.store(depth, std::memory_order_relaxed);
+            sem_post(&_ready);
+        }
+    }
+    catch (...)
+    {
+        _error = std::current_exception();
+        _failed.store(true, std::memory_order_release);
+        sem_post(&_ready);
+    }
+}
+
+} /* namespace PowerMonitor */
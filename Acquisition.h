@@ -0,0 +1,97 @@
+/*
+ * Acquisition.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef ACQUISITION_H_
+#define ACQUISITION_H_
+
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+#include <semaphore.h>
+#include "Adc.h"
+#include "SampleBlock.h"
+#include "SampleSource.h"
+#include "SpscRing.h"
+
+namespace PowerMonitor
+{
+
+//! Reads the ADC on a dedicated thread.
+//!
+//! The acquisition thread refills the ADC buffer, de-interleaves the
+//! requested channels into the next free SampleBlock of a preallocated
+//! lock-free ring and wakes the consumer. When the consumer falls behind
+//! and the ring is full the block is dropped and counted as an overrun,
+//! so that the ADC is never starved of refills.
+//!
+class Acquisition : public SampleSource
+{
+public:
+    //! Constructor.
+    //! \param adc ADC to read.
+    //! \param channels ADC channels to copy into each block.
+    //! \param blockSize maximum number of samples per channel in a block.
+    //! \param queueBlocks number of blocks in the ring.
+    //! \param priority SCHED_FIFO priority of the thread, 0 for normal scheduling.
+    Acquisition(GalileoGen2Adc& adc, const std::vector<unsigned int>& channels,
+            unsigned int blockSize, unsigned int queueBlocks, int priority = 0);
+    //! Destructor, stops the thread.
+    ~Acquisition() override;
+
+    //! Allocates with the cache line alignment of the ring indices, which
+    //! plain new does not guarantee before C++17.
+    static void* operator new(size_t size);
+    static void operator delete(void* p);
+
+    //! Starts the acquisition thread.
+    void start() override;
+    //! Stops the acquisition thread.
+    void stop() override;
+
+    //! Waits for the next block.
+    //! \param timeoutMs maximum time to wait in milliseconds.
+    //! \return Next block or nullptr on timeout. Must be released with release().
+    //! \throw std::exception if the acquisition thread failed.
+    const SampleBlock* next(unsigned int timeoutMs) override;
+    //! Returns the block obtained with next() to the acquisition thread.
+    void release() override;
+
+    //! Gets the number of blocks dropped because the ring was full.
+    unsigned long long overruns() const
+    {
+        return _overruns.load(std::memory_order_relaxed);
+    }
+    //! Gets the number of blocks waiting to be processed.
+    size_t depth() const
+    {
+        return _ring.size();
+    }
+    //! Gets the highest number of blocks waiting since start.
+    size_t maxDepth() const
+    {
+        return _maxDepth.load(std::memory_order_relaxed);
+    }
+
+private:
+    void _run();
+
+    GalileoGen2Adc&                 _adc;       //!< ADC to read.
+    std::vector<unsigned int>       _channels;  //!< ADC channels to copy.
+    SpscRing<SampleBlock>           _ring;      //!< Blocks handed to the consumer.
+    sem_t                           _ready;     //!< Number of committed blocks.
+    int                             _priority;  //!< Real-time priority.
+    std::thread                     _thread;    //!< Acquisition thread.
+    std::atomic<bool>               _running;   //!< Keep the thread running?
+    std::atomic<unsigned long long> _overruns;  //!< Dropped blocks.
+    std::atomic<size_t>             _maxDepth;  //!< Highest queue depth.
+    std::exception_ptr              _error;     //!< Failure of the acquisition thread.
+    std::atomic<bool>               _failed;    //!< Is _error set?
+};
+
+} /* namespace PowerMonitor */
+
+#endif /* ACQUISITION_H_ */
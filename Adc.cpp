@@ -14,7 +14,7 @@
 namespace PowerMonitor
 {
 
-GalileoGen2Adc::GalileoGen2Adc(unsigned int nChannels, unsigned int freq) :
+GalileoGen2Adc::GalileoGen2Adc(unsigned int nChannels, unsigned int freq, unsigned int blockSize, unsigned int kernelBuffers) :
         _nChannels(nChannels)
 {
     int ret;
@@ -57,8 +57,39 @@ GalileoGen2Adc::GalileoGen2Adc(unsigned int nChannels, unsigned int freq) :
         else
             iio_channel_disable(iio_device_get_channel(_adc, i));
     }
-    // Create a buffer holding 1 second worth of values.
-    _adcbuf = iio_device_create_buffer(_adc, freq, false);
+    // Read conversion parameters once.
+    for (unsigned int i = 0; i < nChannels && i < n; ++i)
+    {
+        struct iio_channel* chn = iio_device_get_channel(_adc, i);
+        double scale, offset;
+        // Fall back to the 5 V reference of the adc1x8s102.
+        if (iio_channel_attr_read_double(chn, "scale", &scale) < 0)
+            scale = 5000.0 / 4096;
+        if (iio_channel_attr_read_double(chn, "offset", &offset) < 0)
+            offset = 0.0;
+        const struct iio_data_format* fmt = iio_channel_get_data_format(chn);
+        if (fmt->length != 16)
+        {
+            iio_context_destroy(_iioctx);
+            throw std::runtime_error("Unsupported sample storage size.");
+        }
+        _scale.push_back(scale);
+        _offset.push_back(offset);
+        _format.push_back({ fmt->bits, fmt->shift, fmt->is_signed, fmt->is_be });
+    }
+    // Keep several blocks queued so the kernel can fill the next one
+    // while the previous one is being processed.
+    if (kernelBuffers > 0)
+    {
+        ret = iio_device_set_kernel_buffers_count(_adc, kernelBuffers);
+        if (ret < 0)
+        {
+            iio_context_destroy(_iioctx);
+            throw std::runtime_error("Could not set kernel buffer count: " + std::string(strerror(-ret)));
+        }
+    }
+    // Create a buffer holding 1 second worth of values by default.
+    _adcbuf = iio_device_create_buffer(_adc, blockSize ? blockSize : freq, false);
     if (_adcbuf == nullptr)
     {
         iio_context_destroy(_iioctx);
@@ -81,30 +112,79 @@ void GalileoGen2Adc::refill()
     }
 }
 
-GalileoGen2Adc::const_iterator GalileoGen2Adc::cbegin(unsigned int channel) const
+struct iio_channel* GalileoGen2Adc::_channel(unsigned int channel) const
 {
     struct iio_channel* chn = iio_device_get_channel(_adc, channel);
-    if (chn == nullptr)
+    if (chn == nullptr || channel >= _nChannels)
     {
         throw std::runtime_error("Invalid channel index.");
     }
+    return chn;
+}
+
+GalileoGen2Adc::const_iterator GalileoGen2Adc::cbegin(unsigned int channel) const
+{
+    struct iio_channel* chn = _channel(channel);
     char* ptr = (char*) iio_buffer_first(_adcbuf, chn);
-    return const_iterator(ptr, iio_buffer_step(_adcbuf), chn);
+    return const_iterator(ptr, iio_buffer_step(_adcbuf), chn, _scale[channel], _offset[channel]);
 }
 
 GalileoGen2Adc::const_iterator GalileoGen2Adc::cend(unsigned int channel) const
 {
-    struct iio_channel* chn = iio_device_get_channel(_adc, channel);
-    if (chn == nullptr)
-    {
-        throw std::runtime_error("Invalid channel index.");
-    }
+    struct iio_channel* chn = _channel(channel);
     char* start = (char*) iio_buffer_start(_adcbuf);
     char* ptr = (char*) iio_buffer_first(_adcbuf, chn);
     char* end = (char*) iio_buffer_end(_adcbuf);
     ptrdiff_t distance = end - start;
     
-    return const_iterator(ptr + distance, iio_buffer_step(_adcbuf), chn);
+    return const_iterator(ptr + distance, iio_buffer_step(_adcbuf), chn, _scale[channel], _offset[channel]);
+}
+
+size_t GalileoGen2Adc::size() const
+{
+    char* start = (char*) iio_buffer_start(_adcbuf);
+    char* end = (char*) iio_buffer_end(_adcbuf);
+    return (end - start) / iio_buffer_step(_adcbuf);
+}
+
+float GalileoGen2Adc::scale(unsigned int channel) const
+{
+    _channel(channel);
+    return _scale[channel];
+}
+
+float GalileoGen2Adc::offset(unsigned int channel) const
+{
+    _channel(channel);
+    return _offset[channel];
+}
+
+size_t GalileoGen2Adc::read(const unsigned int* channels, unsigned int count, int16_t* const* out) const
+{
+    _layouts.resize(count);
+    char* start = (char*) iio_buffer_start(_adcbuf);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        struct iio_channel* chn = _channel(channels[i]);
+        _layouts[i].offset = (char*) iio_buffer_first(_adcbuf, chn) - start;
+        _layouts[i].format = _format[channels[i]];
+    }
+    size_t n = size();
+    deinterleave(start, iio_buffer_step(_adcbuf), n, _layouts.data(), count, out);
+    return n;
+}
+
+size_t GalileoGen2Adc::read(const unsigned int* channels, unsigned int count, float* const* out) const
+{
+    size_t n = size();
+    _raw.resize(n * count);
+    _rawChannels.resize(count);
+    for (unsigned int i = 0; i < count; ++i)
+        _rawChannels[i] = &_raw[i * n];
+    read(channels, count, _rawChannels.data());
+    for (unsigned int i = 0; i < count; ++i)
+        convertSamples(_rawChannels[i], out[i], n, _scale[channels[i]], _offset[channels[i]]);
+    return n;
 }
 
 }
@@ -8,8 +8,11 @@
 #ifndef ADC_H_
 #define ADC_H_
 
+#include <cstdint>
 #include <iterator>
+#include <vector>
 #include <iio.h>
+#include "SampleConversion.h"
 
 namespace PowerMonitor
 {
@@ -17,25 +20,31 @@ namespace PowerMonitor
 class GalileoGen2Adc
 {
 public:
-    GalileoGen2Adc(unsigned int nChannels, unsigned int freq);
+    //! Constructor.
+    //! \param nChannels number of channels to enable, starting from 0.
+    //! \param freq sampling frequency in Hz.
+    //! \param blockSize samples per channel in each buffer, 0 for one second.
+    //! \param kernelBuffers number of buffers queued to the kernel, 0 for the libiio default.
+    GalileoGen2Adc(unsigned int nChannels, unsigned int freq, unsigned int blockSize = 0, unsigned int kernelBuffers = 0);
     ~GalileoGen2Adc();
     void refill();
 
     class const_iterator: public std::iterator<std::input_iterator_tag, float, ptrdiff_t, const float*, const float&>
     {
     public:
-        explicit const_iterator(char* first, ptrdiff_t step, struct iio_channel* chn) :
+        explicit const_iterator(char* first, ptrdiff_t step, struct iio_channel* chn, float scale, float offset) :
             _ptr(first),
             _step(step),
-            _chn(chn)
+            _chn(chn),
+            _scale(scale),
+            _offset(offset)
         {
         }
         value_type operator*() const
         {
-            uint16_t tmp;
+            int16_t tmp;
             iio_channel_convert(_chn, &tmp, _ptr);
-            // TODO: Dynamically set these.
-            return tmp * 5000.0 / 4096;
+            return (tmp + _offset) * _scale;
         }
         const_iterator& operator++()
         {
@@ -61,17 +70,51 @@ public:
         ptrdiff_t           _step;
     private:
         struct iio_channel* _chn;
+        float               _scale;
+        float               _offset;
     };
 
     const_iterator cbegin(unsigned int channel) const;
     const_iterator cend(unsigned int channel) const;
 
+    //! Gets the number of samples per channel in the buffer.
+    size_t size() const;
+    //! Gets the scale of a channel read from its scale attribute.
+    //! \param channel channel index.
+    //! \return Millivolts per raw ADC count.
+    float scale(unsigned int channel) const;
+    //! Gets the offset of a channel read from its offset attribute.
+    //! \param channel channel index.
+    //! \return Offset in raw ADC counts.
+    float offset(unsigned int channel) const;
+    //! De-interleaves raw samples of several channels in one pass.
+    //! \param channels channel indices.
+    //! \param count number of channels.
+    //! \param out destination array for each channel, each holding size() samples.
+    //! \return Number of samples written per channel.
+    size_t read(const unsigned int* channels, unsigned int count, int16_t* const* out) const;
+    //! De-interleaves and converts samples of several channels to millivolts.
+    //! \param channels channel indices.
+    //! \param count number of channels.
+    //! \param out destination array for each channel, each holding size() samples.
+    //! \return Number of samples written per channel.
+    size_t read(const unsigned int* channels, unsigned int count, float* const* out) const;
+
 private:
+    struct iio_channel* _channel(unsigned int channel) const;
+
+
     struct iio_context*                                 _iioctx;
     struct iio_device*                                  _adc;
     struct iio_device*                                  _trigger;
     struct iio_buffer*                                  _adcbuf;
     unsigned int                                        _nChannels;
+    std::vector<float>                                  _scale;
+    std::vector<float>                                  _offset;
+    std::vector<SampleFormat>                           _format;
+    mutable std::vector<ChannelLayout>                  _layouts;
+    mutable std::vector<int16_t>                        _raw;
+    mutable std::vector<int16_t*>                       _rawChannels;
 };
 
 }
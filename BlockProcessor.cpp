@@ -0,0 +1,148 @@
+/*
+ * BlockProcessor.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+#include "BlockProcessor.h"
+
+namespace PowerMonitor
+{
+
+static std::vector<unsigned int> delays(const std::vector<Circuit>& channels)
+{
+    std::vector<unsigned int> lengths;
+    for (auto&& c : channels)
+        lengths.push_back(c.delay);
+    return lengths;
+}
+
+template<class T> BlockProcessor<T>::BlockProcessor(unsigned int sampleRate, unsigned int mainsFreq,
+        unsigned int blockSize, const std::vector<Circuit>& channels, unsigned int reportBlocks, float hysteresis,
+        unsigned int filterOrder) :
+        _reportBlocks(reportBlocks ? reportBlocks : 1),
+        _blocks(0),
+        _channels(channels.size()),
+        _filters(channels.size(), 1.0 / sampleRate, 1.0),
+        _delays(delays(channels)),
+        _signals(channels.size(), std::vector<T>(blockSize)),
+        _pointers(channels.size()),
+        _frame(channels.size()),
+        _size(0),
+        _blockSize(0),
+        _hysteresis(hysteresis),
+        _frequency(sampleRate, hysteresis, 3 * (sampleRate / mainsFreq) / 4),
+        _timestamp(0),
+        _result()
+{
+    if (channels.size() < 2)
+        throw std::runtime_error("At least one circuit is needed.");
+    if (filterOrder > 1)
+    {
+        if (!std::is_floating_point<T>::value)
+            throw std::runtime_error("Higher-order high-pass filters need floating point processing.");
+        _biquads.reset(new BiquadFilterBank<T>(channels.size(),
+                Biquad<T>::butterworthHighPass(filterOrder, 1.0 / sampleRate, 1.0)));
+    }
+    for (unsigned int i = 0; i < _channels.size(); ++i)
+    {
+        _channels[i].gain = channels[i].gain;
+        _channels[i].scale = 1.0;
+        _channels[i].squares = 0;
+        _channels[i].power = 0;
+        _pointers[i] = _signals[i].data();
+    }
+    _result.iRMS.resize(circuits());
+    _result.power.resize(circuits());
+    _result.powerFactor.resize(circuits());
+}
+
+template<class T> bool BlockProcessor<T>::process(const SampleBlock& block)
+{
+    const unsigned int n = _channels.size();
+    if (block.channels() != n)
+        throw std::runtime_error("Unexpected number of channels in sample block.");
+    if (block.size > _signals[Voltage].size())
+        throw std::runtime_error("Sample block larger than block size.");
+    unsigned int size = block.size;
+
+    StageTimer timer(StageConvert, _sampler(size));
+    for (unsigned int c = 0; c < n; ++c)
+    {
+        float scale = block.scale[c] * _channels[c].gain;
+        Traits::load(block.channel(c), _pointers[c], size, scale, block.offset[c]);
+        _channels[c].scale = Traits::unitScale(scale);
+    }
+    timer.next(StageProcess);
+    _frequency.setHysteresis((T) (_hysteresis / _channels[Voltage].scale));
+    // Filter, delay, sum and estimate the frequency in one pass, see Meter
+    // for the reference implementations of the sums.
+    T* frame = _frame.data();
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        for (unsigned int c = 0; c < n; ++c)
+            frame[c] = _pointers[c][i];
+        if (_biquads)
+            (*_biquads)(frame);
+        else
+            _filters(frame);
+        const T v = _delays(Voltage, frame[Voltage]);
+        _pointers[Voltage][i] = v;
+        _channels[Voltage].squares += (Accumulator) v * v;
+        for (unsigned int c = Voltage + 1; c < n; ++c)
+        {
+            ChannelState& state = _channels[c];
+            const T s = _delays(c, frame[c]);
+            _pointers[c][i] = s;
+            state.squares += (Accumulator) s * s;
+            state.power += (Accumulator) s * v;
+        }
+        _frequency(v);
+    }
+    timer.stop();
+
+    _size += size;
+    _blockSize = size;
+    _timestamp = block.timestamp;
+
+    if (++_blocks < _reportBlocks)
+        return false;
+    _finish();
+    return true;
+}
+
+template<class T> void BlockProcessor<T>::_finish()
+{
+    unsigned int size = _size;
+    _result.timestamp = _timestamp;
+    if (size > 0)
+    {
+        const ChannelState& voltage = _channels[Voltage];
+        _result.vRMS = voltage.scale * std::sqrt((double) voltage.squares / size);
+        _result.frequency = _frequency.average();
+        for (unsigned int i = 0; i < circuits(); ++i)
+        {
+            const ChannelState& current = _channels[i + 1];
+            _result.iRMS[i] = current.scale * std::sqrt((double) current.squares / size);
+            _result.power[i] = voltage.scale * current.scale * ((double) current.power / size);
+            _result.powerFactor[i] = _result.power[i] / (_result.iRMS[i] * _result.vRMS);
+        }
+    }
+
+    for (auto&& state : _channels)
+    {
+        state.squares = 0;
+        state.power = 0;
+    }
+    _size = 0;
+    _frequency.reset();
+    _blocks = 0;
+}
+
+template class BlockProcessor<float>;
+template class BlockProcessor<int32_t>;
+
+} /* namespace PowerMonitor */
@@ -0,0 +1,200 @@
+/*
+ * BlockProcessor.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef BLOCKPROCESSOR_H_
+#define BLOCKPROCESSOR_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Circuit.h"
+#include "Delay.h"
+#include "FilterBank.h"
+#include "FrequencyEstimator.h"
+#include "Metrics.h"
+#include "SampleBlock.h"
+#include "SampleConversion.h"
+
+namespace PowerMonitor
+{
+
+//! Results calculated from one reporting window of samples.
+struct BlockResult
+{
+    long long timestamp;                //!< Time of the last sample in nanoseconds since Unix epoch.
+    float vRMS;                         //!< Voltage RMS in volts.
+    float frequency;                    //!< Mains frequency in Hz.
+    std::vector<float> iRMS;            //!< Circuit current RMS in amperes.
+    std::vector<float> power;           //!< Circuit real power in watts.
+    std::vector<float> powerFactor;     //!< Circuit power factor.
+};
+
+//! Sample arithmetic of the block processor.
+//!
+//! Floating point samples are converted to volts and amperes when they are
+//! loaded and summed in double precision.
+//!
+template<class T> struct SampleTraits
+{
+    typedef double Accumulator;
+
+    static void load(const int16_t* in, T* out, size_t count, float scale, float offset)
+    {
+        convertSamples(in, out, count, scale, offset);
+    }
+    static double unitScale(float)
+    {
+        return 1.0;
+    }
+};
+
+//! Fixed-point sample arithmetic.
+//!
+//! Raw ADC codes are shifted to Q8 so the high-pass filter keeps fractional
+//! resolution, and all sums are exact 64-bit integers. The ADC offset is
+//! not applied since the high-pass filter removes it anyway. Conversion to
+//! engineering units happens once per reporting window. Needs no FPU in the
+//! per-sample loop, which suits the Quark X1000.
+//!
+template<> struct SampleTraits<int32_t>
+{
+    typedef int64_t Accumulator;
+    static const int fractionBits = 8;
+
+    static void load(const int16_t* in, int32_t* out, size_t count, float, float)
+    {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = (int32_t) in[i] << fractionBits;
+    }
+    static double unitScale(float scale)
+    {
+        return (double) scale / (1 << fractionBits);
+    }
+};
+
+//! Multi-circuit block processing engine.
+//!
+//! Converts, filters and delays the voltage channel and any number of
+//! current channels of a block of raw samples and calculates the results
+//! of every circuit. The pipeline is built once from the circuit list: one
+//! flat array of per-channel state, a high-pass filter bank and a delay
+//! bank. Each frame of the block is filtered, delayed, summed and fed to
+//! the frequency estimator in a single per-sample loop, so the cost per
+//! sample grows linearly with the number of channels. Float sums are
+//! accumulated in double precision, fixed-point sums exactly in integers,
+//! so the results match running the Meter functions on the filtered
+//! signals within the tolerance documented in Meter.
+//!
+//! The ADC may deliver blocks shorter than the reporting window, down to
+//! a single mains cycle. Sums are carried over from block to block until
+//! the window is complete. The frequency is the average over the mains
+//! cycles completed in the window, see FrequencyEstimator; a window without
+//! a complete cycle repeats the last value.
+//!
+//! T is the sample type of the pipeline, float or int32_t for fixed point,
+//! see SampleTraits. Both are instantiated in BlockProcessor.cpp.
+//!
+template<class T> class BlockProcessor
+{
+public:
+    typedef SampleTraits<T> Traits;
+    typedef typename Traits::Accumulator Accumulator;
+
+    //! Index of the voltage channel. Circuit i is channel i + 1.
+    static const unsigned int Voltage = 0;
+
+    //! Constructor.
+    //! \param sampleRate sampling rate in Hz.
+    //! \param mainsFreq nominal mains frequency in Hz.
+    //! \param blockSize maximum number of samples per channel in an ADC block.
+    //! \param channels voltage channel followed by the circuits, see readCircuits().
+    //! \param reportBlocks number of blocks per reporting window.
+    //! \param hysteresis zero crossing hysteresis of the frequency estimator in volts.
+    //! \param filterOrder order of the DC removal filter. 1 is the first-order
+    //! HighPassFilter, higher orders a Butterworth cascade of biquads, float
+    //! only, see BiquadFilterBank.
+    BlockProcessor(unsigned int sampleRate, unsigned int mainsFreq, unsigned int blockSize,
+            const std::vector<Circuit>& channels, unsigned int reportBlocks = 1, float hysteresis = 10.f,
+            unsigned int filterOrder = 1);
+
+    //! Processes a block of samples.
+    //! \param block raw samples in the order of the channels.
+    //! \return True if a reporting window was completed.
+    bool process(const SampleBlock& block);
+
+    //! Gets the results of the last completed reporting window.
+    const BlockResult& result() const
+    {
+        return _result;
+    }
+
+    //! Gets the number of channels, the voltage and the circuits.
+    unsigned int channels() const
+    {
+        return _channels.size();
+    }
+
+    //! Gets the number of circuits.
+    unsigned int circuits() const
+    {
+        return _channels.size() - 1;
+    }
+
+    //! Gets the filtered signal of the last processed block.
+    //! \param channel signal to get.
+    //! \return Filtered samples, blockSize() valid. Multiply by unitScale()
+    //! to get volts or amperes.
+    const std::vector<T>& signal(unsigned int channel) const
+    {
+        return _signals[channel];
+    }
+
+    //! Gets the factor from signal() samples to engineering units.
+    //! \param channel signal to get.
+    double unitScale(unsigned int channel) const
+    {
+        return _channels[channel].scale;
+    }
+
+    //! Gets the number of samples per channel in the last processed block.
+    size_t blockSize() const
+    {
+        return _blockSize;
+    }
+
+private:
+    //! Processing state of one channel.
+    struct ChannelState
+    {
+        float           gain;       //!< Volts or amperes per millivolt.
+        double          scale;      //!< Signal units to volts or amperes.
+        Accumulator     squares;    //!< Sum of squares.
+        Accumulator     power;      //!< Sum of instantaneous power with the voltage.
+    };
+
+    void _finish();
+
+    unsigned int                    _reportBlocks;              //!< Blocks per reporting window.
+    unsigned int                    _blocks;                    //!< Blocks in current window.
+    std::vector<ChannelState>       _channels;                  //!< Per-channel state.
+    HighPassFilterBank<T>           _filters;                   //!< DC removal filters.
+    std::unique_ptr<BiquadFilterBank<T> > _biquads;            //!< Higher-order DC removal, if any.
+    DelayBank<T>                    _delays;                    //!< Phase shifts.
+    std::vector<std::vector<T> >    _signals;                   //!< Filtered signals.
+    std::vector<T*>                 _pointers;                  //!< Filtered signal arrays.
+    std::vector<T>                  _frame;                     //!< One sample of every channel.
+    unsigned int                    _size;                      //!< Samples in current window.
+    size_t                          _blockSize;                 //!< Samples in last block.
+    float                           _hysteresis;                //!< Frequency hysteresis in volts.
+    FrequencyEstimator<T>           _frequency;                 //!< Voltage frequency.
+    long long                       _timestamp;                 //!< Time of the last sample.
+    BlockResult                     _result;                    //!< Last results.
+    MetricsSampler                  _sampler;                   //!< Blocks to time.
+};
+
+} /* namespace PowerMonitor */
+
+#endif /* BLOCKPROCESSOR_H_ */
@@ -0,0 +1,44 @@
+/*
+ * Calibration.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef CALIBRATION_H_
+#define CALIBRATION_H_
+
+#define BURDEN_RESISTANCE 99.5f // Ohms
+#define VOLTAGE_DIVIDER_RATIO 0.138268156f // 9.9 / (61.7 + 9.9)
+#define CURRENT_TRANSFORMER_RATIO 0.0005f // 50 mA / 100 A
+#define TRANSFORMER_RATIO (0.048869565f * 0.9657f) // 11.24 V / 230 V * calibration factor
+
+namespace PowerMonitor
+{
+
+inline float voltageToVoltage(float v)
+{
+    // Millivolts from ADC to mains voltage in volts.
+    return v / 1000.f / VOLTAGE_DIVIDER_RATIO / TRANSFORMER_RATIO;
+}
+
+inline float voltageToCurrent(float v)
+{
+    // Millivolts from ADC to mains current in amperes.
+    return v / 1000.f / BURDEN_RESISTANCE / CURRENT_TRANSFORMER_RATIO;
+}
+
+inline float voltageGain(float dividerRatio = VOLTAGE_DIVIDER_RATIO, float transformerRatio = TRANSFORMER_RATIO)
+{
+    // Mains volts per millivolt from ADC.
+    return 1.f / 1000.f / dividerRatio / transformerRatio;
+}
+
+inline float currentGain(float burdenResistance = BURDEN_RESISTANCE, float transformerRatio = CURRENT_TRANSFORMER_RATIO)
+{
+    // Mains amperes per millivolt from ADC.
+    return 1.f / 1000.f / burdenResistance / transformerRatio;
+}
+
+}
+
+#endif /* CALIBRATION_H_ */
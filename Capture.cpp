@@ -0,0 +1,206 @@
+/*
+ * Capture.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Capture.h"
+
+namespace PowerMonitor
+{
+
+static const char MAGIC[8] = { 'P', 'M', 'C', 'A', 'P', 'T', '0', '1' };
+
+//! Header of a stored block.
+struct BlockHeader
+{
+    int64_t     timestamp;  //!< Time of the last frame in nanoseconds since Unix epoch.
+    uint32_t    frames;     //!< Number of frames.
+    uint32_t    reserved;   //!< Zero.
+};
+
+static size_t padded(size_t size)
+{
+    return (size + 7) & ~(size_t) 7;
+}
+
+static size_t headerSize(unsigned int channels)
+{
+    return padded(sizeof(MAGIC) + 2 * sizeof(uint32_t) + 2 * channels * sizeof(float));
+}
+
+CaptureWriter::CaptureWriter(const std::string& path, unsigned int channels, unsigned int sampleRate) :
+        _channels(channels),
+        _sampleRate(sampleRate),
+        _header(false)
+{
+    _file = fopen(path.c_str(), "wb");
+    if (_file == nullptr)
+        throw std::runtime_error("Could not create capture file: " + std::string(strerror(errno)));
+    setvbuf(_file, nullptr, _IOFBF, 1 << 20);
+}
+
+CaptureWriter::CaptureWriter(FILE* file, unsigned int channels, unsigned int sampleRate) :
+        _file(file),
+        _channels(channels),
+        _sampleRate(sampleRate),
+        _header(false)
+{
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    fclose(_file);
+}
+
+void CaptureWriter::write(const SampleBlock& block)
+{
+    static const char zeros[8] = { 0 };
+    if (block.channels() != _channels)
+        throw std::runtime_error("Unexpected number of channels in sample block.");
+    if (!_header)
+    {
+        uint32_t values[2] = { _channels, _sampleRate };
+        _write(MAGIC, sizeof(MAGIC));
+        _write(values, sizeof(values));
+        _write(block.scale.data(), _channels * sizeof(float));
+        _write(block.offset.data(), _channels * sizeof(float));
+        size_t size = sizeof(MAGIC) + sizeof(values) + 2 * _channels * sizeof(float);
+        _write(zeros, headerSize(_channels) - size);
+        _header = true;
+    }
+
+    // Interleave the channels back to frames.
+    const size_t frames = block.size;
+    _frames.resize(frames * _channels);
+    for (unsigned int c = 0; c < _channels; ++c)
+    {
+        const int16_t* in = block.channel(c);
+        int16_t* out = &_frames[c];
+        for (size_t i = 0; i < frames; ++i, out += _channels)
+            *out = in[i];
+    }
+    BlockHeader header = { block.timestamp, (uint32_t) frames, 0 };
+    size_t size = _frames.size() * sizeof(int16_t);
+    _write(&header, sizeof(header));
+    _write(_frames.data(), size);
+    _write(zeros, padded(size) - size);
+}
+
+void CaptureWriter::_write(const void* data, size_t size)
+{
+    if (size > 0 && fwrite(data, size, 1, _file) != 1)
+        throw std::runtime_error("Could not write capture file: " + std::string(strerror(errno)));
+}
+
+ReplaySource::ReplaySource(const std::string& path, unsigned int blockSize) :
+        _map(nullptr),
+        _size(0),
+        _frames(nullptr),
+        _remaining(0),
+        _timestamp(0)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Could not open capture file: " + std::string(strerror(errno)));
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+    {
+        close(fd);
+        throw std::runtime_error("Could not read capture file: " + std::string(strerror(errno)));
+    }
+    _size = st.st_size;
+    if (_size < headerSize(0))
+    {
+        close(fd);
+        throw std::runtime_error("Not a capture file: " + path);
+    }
+    _map = (char*) mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (_map == MAP_FAILED)
+        throw std::runtime_error("Could not map capture file: " + std::string(strerror(errno)));
+    if (memcmp(_map, MAGIC, sizeof(MAGIC)) != 0)
+    {
+        munmap(_map, _size);
+        throw std::runtime_error("Not a capture file: " + path);
+    }
+    madvise(_map, _size, MADV_SEQUENTIAL);
+
+    uint32_t values[2];
+    memcpy(values, _map + sizeof(MAGIC), sizeof(values));
+    unsigned int channels = values[0];
+    _sampleRate = values[1];
+    if (channels == 0 || _sampleRate == 0 || headerSize(channels) > _size)
+    {
+        munmap(_map, _size);
+        throw std::runtime_error("Invalid capture file header: " + path);
+    }
+    _block = SampleBlock(channels, blockSize);
+    const char* params = _map + sizeof(MAGIC) + sizeof(values);
+    memcpy(_block.scale.data(), params, channels * sizeof(float));
+    memcpy(_block.offset.data(), params + channels * sizeof(float), channels * sizeof(float));
+    _layouts.resize(channels);
+    _out.resize(channels);
+    for (unsigned int c = 0; c < channels; ++c)
+    {
+        _layouts[c].offset = c * sizeof(int16_t);
+        _layouts[c].format = SampleFormat { 16, 0, true, false };
+        _out[c] = _block.channel(c);
+    }
+    _position = _map + headerSize(channels);
+    _end = _map + _size;
+}
+
+ReplaySource::~ReplaySource()
+{
+    munmap(_map, _size);
+}
+
+const SampleBlock* ReplaySource::next(unsigned int)
+{
+    if (_remaining == 0 && !_nextRecord())
+        return nullptr;
+    const unsigned int channels = _block.channels();
+    const size_t count = std::min(_remaining, _block.capacity);
+    deinterleave(_frames, channels * sizeof(int16_t), count, _layouts.data(), channels, _out.data());
+    _frames += count * channels * sizeof(int16_t);
+    _remaining -= count;
+    _block.size = count;
+    // Time of the last frame of this part of the stored block.
+    _block.timestamp = _timestamp - (long long) (_remaining * 1000000000ULL / _sampleRate);
+    return &_block;
+}
+
+bool ReplaySource::_nextRecord()
+{
+    while (_position != _end)
+    {
+        BlockHeader header;
+        size_t frameSize = _block.channels() * sizeof(int16_t);
+        if ((size_t) (_end - _position) < sizeof(header))
+            break;
+        memcpy(&header, _position, sizeof(header));
+        size_t size = padded(header.frames * frameSize);
+        if ((size_t) (_end - _position) - sizeof(header) < size)
+            break;
+        _frames = _position + sizeof(header);
+        _remaining = header.frames;
+        _timestamp = header.timestamp;
+        _position += sizeof(header) + size;
+        if (_remaining > 0)
+            return true;
+    }
+    // Ignore a truncated block at the end.
+    _position = _end;
+    return false;
+}
+
+} /* namespace PowerMonitor */
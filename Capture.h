@@ -0,0 +1,127 @@
+/*
+ * Capture.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef CAPTURE_H_
+#define CAPTURE_H_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "SampleBlock.h"
+#include "SampleConversion.h"
+#include "SampleSource.h"
+
+namespace PowerMonitor
+{
+
+//! Writes raw sample blocks to a capture file.
+//!
+//! The file starts with a header holding the magic "PMCAPT01", the number
+//! of channels and the sampling rate as 32-bit integers and the scale and
+//! offset of each channel as floats. Each block follows as a 64-bit
+//! timestamp, a 32-bit frame count, 32 reserved bits and the raw samples
+//! interleaved one frame at a time. Header and blocks are padded to 8
+//! bytes. Everything is stored in host byte order.
+//!
+class CaptureWriter
+{
+public:
+    //! Constructor, creates the file.
+    //! \param path capture file path.
+    //! \param channels number of channels in each block.
+    //! \param sampleRate sampling rate in Hz.
+    CaptureWriter(const std::string& path, unsigned int channels, unsigned int sampleRate);
+    //! Constructor, writes to an open stream, e.g. from open_memstream().
+    //! \param file stream to write to, closed by the destructor.
+    //! \param channels number of channels in each block.
+    //! \param sampleRate sampling rate in Hz.
+    CaptureWriter(FILE* file, unsigned int channels, unsigned int sampleRate);
+    //! Destructor, flushes and closes the file.
+    ~CaptureWriter();
+
+    //! Appends a block. The header is written with the first block, taking
+    //! the scale and offset from it.
+    //! \param block block to write.
+    void write(const SampleBlock& block);
+
+private:
+    CaptureWriter(const CaptureWriter&);
+    CaptureWriter& operator=(const CaptureWriter&);
+
+    void _write(const void* data, size_t size);
+
+    FILE*                   _file;          //!< Capture file.
+    unsigned int            _channels;      //!< Channels per block.
+    unsigned int            _sampleRate;    //!< Sampling rate in Hz.
+    bool                    _header;        //!< Header written?
+    std::vector<int16_t>    _frames;        //!< Interleaving buffer.
+};
+
+//! Replays a capture file as fast as possible.
+//!
+//! The file is memory-mapped and each stored block is de-interleaved into
+//! blocks of at most blockSize samples, so a file captured with a larger
+//! block size can still be fed to the processor. Timestamps are taken from
+//! the file. A truncated last block is ignored.
+//!
+class ReplaySource : public SampleSource
+{
+public:
+    //! Constructor, maps the file.
+    //! \param path capture file path.
+    //! \param blockSize maximum number of samples per channel in a block.
+    ReplaySource(const std::string& path, unsigned int blockSize);
+    //! Destructor, unmaps the file.
+    ~ReplaySource() override;
+
+    void start() override
+    {
+    }
+    void stop() override
+    {
+    }
+    const SampleBlock* next(unsigned int timeoutMs) override;
+    void release() override
+    {
+    }
+    bool finished() const override
+    {
+        return _position == _end && _remaining == 0;
+    }
+
+    //! Gets the number of channels in the file.
+    unsigned int channels() const
+    {
+        return _block.channels();
+    }
+    //! Gets the sampling rate of the file in Hz.
+    unsigned int sampleRate() const
+    {
+        return _sampleRate;
+    }
+
+private:
+    ReplaySource(const ReplaySource&);
+    ReplaySource& operator=(const ReplaySource&);
+
+    bool _nextRecord();
+
+    char*                       _map;           //!< Mapped file.
+    size_t                      _size;          //!< Size of the mapping.
+    const char*                 _position;      //!< Next stored block.
+    const char*                 _end;           //!< End of complete blocks.
+    unsigned int                _sampleRate;    //!< Sampling rate in Hz.
+    const char*                 _frames;        //!< Remaining frames of the current stored block.
+    size_t                      _remaining;     //!< Number of remaining frames.
+    long long                   _timestamp;     //!< Time of the last frame of the stored block.
+    std::vector<ChannelLayout>  _layouts;       //!< Channel positions in a frame.
+    std::vector<int16_t*>       _out;           //!< Channel arrays of _block.
+    SampleBlock                 _block;         //!< Block handed out.
+};
+
+} /* namespace PowerMonitor */
+
+#endif /* CAPTURE_H_ */
@@ -0,0 +1,73 @@
+/*
+ * Circuit.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <stdexcept>
+#include "Calibration.h"
+#include "Circuit.h"
+#include "Configuration.h"
+
+namespace PowerMonitor
+{
+
+// Inputs of the adc1x8s102.
+static const unsigned int ADC_INPUTS = 8;
+
+std::vector<Circuit> readCircuits(Configuration& conf, unsigned int sampleRate, unsigned int mainsFreq)
+{
+    const unsigned int cycle = sampleRate / mainsFreq;
+    std::vector<Circuit> circuits;
+
+    Circuit voltage;
+    voltage.name = "voltage";
+    voltage.input = conf.get("PowerMonitor.voltage.input", 4u);
+    voltage.phase = 1;
+    voltage.gain = voltageGain(conf.get("PowerMonitor.voltage.divider", VOLTAGE_DIVIDER_RATIO),
+            conf.get("PowerMonitor.voltage.transformer", TRANSFORMER_RATIO));
+    voltage.delay = 0;
+    circuits.push_back(voltage);
+
+    std::vector<Configuration> items = conf.getObjects("PowerMonitor.circuits");
+    if (items.empty())
+    {
+        const char* names[] = { "l1", "l2", "l3" };
+        const unsigned int inputs[] = { 1, 3, 0 };
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            Circuit c;
+            c.name = names[i];
+            c.input = inputs[i];
+            c.phase = i + 1;
+            c.gain = currentGain();
+            c.delay = ((4 - c.phase) % 3) * cycle / 3;
+            circuits.push_back(c);
+        }
+    }
+    for (auto&& item : items)
+    {
+        Circuit c;
+        c.input = item.get<unsigned int>("input");
+        c.name = item.get("name", "in" + std::to_string(c.input));
+        c.phase = item.get("phase", 1u);
+        if (c.phase < 1 || c.phase > 3)
+            throw std::runtime_error("Invalid phase for circuit " + c.name + ".");
+        c.gain = currentGain(item.get("burden", BURDEN_RESISTANCE), item.get("ratio", CURRENT_TRANSFORMER_RATIO));
+        c.delay = item.get("delay", ((4 - c.phase) % 3) * cycle / 3);
+        circuits.push_back(c);
+    }
+    for (size_t i = 0; i < circuits.size(); ++i)
+    {
+        if (circuits[i].input >= ADC_INPUTS)
+            throw std::runtime_error("Invalid ADC input for " + circuits[i].name + ".");
+        for (size_t j = 0; j < i; ++j)
+        {
+            if (circuits[j].input == circuits[i].input)
+                throw std::runtime_error("ADC input of " + circuits[i].name + " is already in use.");
+        }
+    }
+    return circuits;
+}
+
+} /* namespace PowerMonitor */
@@ -0,0 +1,52 @@
+/*
+ * Circuit.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef CIRCUIT_H_
+#define CIRCUIT_H_
+
+#include <string>
+#include <vector>
+
+namespace PowerMonitor
+{
+
+class Configuration;
+
+//! Metered input channel.
+struct Circuit
+{
+    std::string     name;       //!< Name in results.
+    unsigned int    input;      //!< ADC input.
+    unsigned int    phase;      //!< Mains phase, 1 to 3.
+    float           gain;       //!< Volts or amperes per millivolt at the ADC.
+    unsigned int    delay;      //!< Delay in samples to align with the voltage.
+};
+
+//! Reads the metered channels from the configuration.
+//!
+//! The mains voltage is measured on phase 1 only. Currents of phases 2 and
+//! 3 are delayed by 2/3 and 1/3 of a mains cycle, which lines them up with
+//! their own phase voltage as if it had been measured. Example:
+//!
+//!     "voltage": { "input": 4, "divider": 0.138268156, "transformer": 0.0472 },
+//!     "circuits": [
+//!         { "name": "l1", "input": 1, "phase": 1, "burden": 99.5, "ratio": 0.0005 },
+//!         { "name": "heatpump", "input": 5, "phase": 2, "delay": 27 }
+//!     ]
+//!
+//! Calibration defaults to the values in Calibration.h and the delay to the
+//! one of the phase. Without circuits the three phases l1, l2 and l3 are
+//! read from inputs 1, 3 and 0 as before.
+//!
+//! \param conf configuration with PowerMonitor.voltage and PowerMonitor.circuits.
+//! \param sampleRate sampling rate in Hz.
+//! \param mainsFreq nominal mains frequency in Hz.
+//! \return The voltage channel followed by the circuits.
+std::vector<Circuit> readCircuits(Configuration& conf, unsigned int sampleRate, unsigned int mainsFreq);
+
+} /* namespace PowerMonitor */
+
+#endif /* CIRCUIT_H_ */
@@ -26,6 +26,12 @@ public:
     {
         boost::property_tree::read_json(configFile, _tree);
     }
+    //! Is a configuration option set?
+    //! \param option option name.
+    bool has(const std::string& option) const
+    {
+        return (bool) _tree.get_child_optional(option);
+    }
     //! Gets a configuration option.
     //! \param option option name.
     //! \return Option value.
@@ -51,7 +57,26 @@ public:
             r.push_back(item.second.get_value<T>());
         return r;
     }
+    //! Gets a configuration option array of objects.
+    //! \param option option name.
+    //! \return Objects as configurations, empty if the option is not set.
+    std::vector<Configuration> getObjects(const std::string& option)
+    {
+        std::vector<Configuration> r;
+        auto child = _tree.get_child_optional(option);
+        if (child)
+        {
+            for (auto&& item : *child)
+                r.push_back(Configuration(item.second));
+        }
+        return r;
+    }
 private:
+    Configuration(const boost::property_tree::ptree& tree) :
+            _tree(tree)
+    {
+    }
+
     boost::property_tree::ptree _tree;
 };
 
@@ -0,0 +1,160 @@
+/*
+ * Deadband.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "Configuration.h"
+#include "Deadband.h"
+
+namespace PowerMonitor
+{
+
+Deadband::Deadband(const std::vector<Rule>& rules, double heartbeat, bool swingingDoor) :
+        _previous(rules.size()),
+        _previousTime(0),
+        _end(rules.size()),
+        _endTime(0),
+        _writtenTime(0),
+        _heartbeat(heartbeat * 1e9),
+        _swingingDoor(swingingDoor),
+        _first(true),
+        _pending(false),
+        _suppressed(0)
+{
+    for (auto&& rule : rules)
+        _fields.push_back(Field { rule, 0.f, HUGE_VAL, -HUGE_VAL });
+}
+
+float Deadband::_band(const Field& field) const
+{
+    return std::max(field.rule.absolute, field.rule.relative * std::fabs(field.written));
+}
+
+void Deadband::_write(long long timestamp, const float* values)
+{
+    for (size_t i = 0; i < _fields.size(); ++i)
+    {
+        _fields[i].written = values[i];
+        _fields[i].upper = HUGE_VAL;
+        _fields[i].lower = -HUGE_VAL;
+    }
+    _writtenTime = timestamp;
+}
+
+void Deadband::_endSegment()
+{
+    // The value of the previous sample is moved into the corridor, by at
+    // most its band, so the line from the last written sample fits all
+    // samples in between.
+    const double segment = _previousTime - _writtenTime;
+    for (size_t i = 0; i < _fields.size(); ++i)
+    {
+        const Field& f = _fields[i];
+        double slope = (_previous[i] - f.written) / segment;
+        slope = std::min(std::max(slope, f.lower), f.upper);
+        _end[i] = f.written + slope * segment;
+    }
+    _endTime = _previousTime;
+    _write(_endTime, _end.data());
+}
+
+unsigned int Deadband::update(long long timestamp, const float* values)
+{
+    unsigned int emit = 0;
+    bool finite = !_first;
+    for (size_t i = 0; i < _fields.size() && finite; ++i)
+        finite = std::isfinite(values[i]) && std::isfinite(_fields[i].written);
+
+    if (!finite)
+    {
+        // Nothing to interpolate from or to, write as is.
+        if (_swingingDoor && _pending)
+        {
+            _endSegment();
+            emit = EmitPrevious;
+        }
+        emit |= EmitCurrent;
+    }
+    else if (_swingingDoor)
+    {
+        // Narrow the corridor of lines from the last written sample.
+        const double dt = timestamp - _writtenTime;
+        bool closed = false;
+        for (size_t i = 0; i < _fields.size(); ++i)
+        {
+            const Field& f = _fields[i];
+            const float band = _band(f);
+            closed |= std::max(f.lower, (values[i] - band - f.written) / dt)
+                    > std::min(f.upper, (values[i] + band - f.written) / dt);
+        }
+        // A heartbeat can only write the current sample if its line fits.
+        bool fits = false;
+        if (!closed)
+        {
+            fits = true;
+            for (size_t i = 0; i < _fields.size(); ++i)
+            {
+                Field& f = _fields[i];
+                const float band = _band(f);
+                const double slope = (values[i] - f.written) / dt;
+                f.upper = std::min(f.upper, (values[i] + band - f.written) / dt);
+                f.lower = std::max(f.lower, (values[i] - band - f.written) / dt);
+                fits &= slope >= f.lower && slope <= f.upper;
+            }
+        }
+        if ((closed || (!fits && timestamp - _writtenTime >= _heartbeat)) && _pending)
+        {
+            _endSegment();
+            emit = EmitPrevious;
+            const double restart = timestamp - _previousTime;
+            for (size_t i = 0; i < _fields.size(); ++i)
+            {
+                Field& f = _fields[i];
+                const float band = _band(f);
+                f.upper = (values[i] + band - f.written) / restart;
+                f.lower = (values[i] - band - f.written) / restart;
+            }
+        }
+        else if (closed)
+            emit = EmitCurrent;
+    }
+    else
+    {
+        for (size_t i = 0; i < _fields.size(); ++i)
+        {
+            if (std::fabs(values[i] - _fields[i].written) > _band(_fields[i]))
+            {
+                emit = EmitCurrent;
+                break;
+            }
+        }
+    }
+    if (timestamp - _writtenTime >= _heartbeat)
+        emit |= EmitCurrent;
+
+    if (emit & EmitCurrent)
+        _write(timestamp, values);
+    if (_pending && !(emit & EmitPrevious))
+        _suppressed++;
+    std::copy(values, values + _fields.size(), _previous.begin());
+    _previousTime = timestamp;
+    _pending = !(emit & EmitCurrent);
+    _first = false;
+    return emit;
+}
+
+Deadband::Rule readDeadbandRule(Configuration& conf, const std::string& field, const std::string& group)
+{
+    std::string path = "PowerMonitor.deadband.rules." + field;
+    if (!conf.has(path))
+        path = "PowerMonitor.deadband.rules." + group;
+    Deadband::Rule rule;
+    rule.absolute = conf.get(path + ".absolute", 0.f);
+    rule.relative = conf.get(path + ".relative", 0.f);
+    return rule;
+}
+
+} /* namespace PowerMonitor */
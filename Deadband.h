@@ -0,0 +1,126 @@
+/*
+ * Deadband.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef DEADBAND_H_
+#define DEADBAND_H_
+
+#include <string>
+#include <vector>
+
+namespace PowerMonitor
+{
+
+class Configuration;
+
+//! Change-driven reporting of the fields of a point.
+//!
+//! Decides for each new sample of a point whether it has to be written.
+//! Every field has a band of max(absolute, relative * |value|) around the
+//! last written value, and the point is written when a field leaves its
+//! band or when the heartbeat interval has passed since the last write.
+//! Stepping from written value to written value then reconstructs every
+//! field within its band.
+//!
+//! With the swinging door algorithm the band is a corridor around the
+//! straight line from the last written sample instead. The corridor
+//! narrows with each sample, and when no line through all samples fits
+//! anymore, the sample before the current one is written, moved into the
+//! corridor if needed. Linear interpolation between written samples then
+//! reconstructs every field within its band, with fewer points than the
+//! plain deadband on ramps.
+//!
+//! All fields of a point are written together, so the point is kept as
+//! is. The state is allocated once, update() does not allocate.
+//!
+class Deadband
+{
+public:
+    //! Band of a field.
+    struct Rule
+    {
+        float absolute;     //!< Absolute band in the units of the field.
+        float relative;     //!< Band relative to the written value.
+    };
+
+    //! Bits of the result of update().
+    enum Emit
+    {
+        EmitPrevious = 1,   //!< Write the previous sample, see previous().
+        EmitCurrent = 2     //!< Write the current sample.
+    };
+
+    //! Constructor.
+    //! \param rules band of each field.
+    //! \param heartbeat maximum time between writes in seconds.
+    //! \param swingingDoor use the swinging door algorithm.
+    Deadband(const std::vector<Rule>& rules, double heartbeat, bool swingingDoor);
+
+    //! Decides on a new sample.
+    //! \param timestamp time of the sample in nanoseconds.
+    //! \param values one value per rule.
+    //! \return Emit bits, 0 if nothing needs to be written. The previous
+    //! sample comes before the current one.
+    unsigned int update(long long timestamp, const float* values);
+
+    //! Gets the timestamp of the previous sample to write on EmitPrevious.
+    long long previousTimestamp() const
+    {
+        return _endTime;
+    }
+
+    //! Gets the values of the previous sample to write on EmitPrevious.
+    const float* previous() const
+    {
+        return _end.data();
+    }
+
+    //! Gets the number of samples that were not written.
+    unsigned long long suppressed() const
+    {
+        return _suppressed;
+    }
+
+private:
+    //! State of one field.
+    struct Field
+    {
+        Rule    rule;       //!< Band.
+        float   written;    //!< Last written value.
+        double  upper;      //!< Smallest slope to the upper band edges since then.
+        double  lower;      //!< Largest slope to the lower band edges since then.
+    };
+
+    float _band(const Field& field) const;
+    void _write(long long timestamp, const float* values);
+    void _endSegment();
+
+    std::vector<Field>  _fields;            //!< Per-field state.
+    std::vector<float>  _previous;          //!< Previous sample.
+    long long           _previousTime;      //!< Time of the previous sample.
+    std::vector<float>  _end;               //!< Written previous sample.
+    long long           _endTime;           //!< Time of the written previous sample.
+    long long           _writtenTime;       //!< Time of the last written sample.
+    long long           _heartbeat;         //!< Maximum time between writes in nanoseconds.
+    bool                _swingingDoor;      //!< Swinging door or plain deadband?
+    bool                _first;             //!< No sample yet?
+    bool                _pending;           //!< Previous sample not written?
+    unsigned long long  _suppressed;        //!< Samples not written.
+};
+
+//! Reads the band of a field from PowerMonitor.deadband.rules.
+//!
+//! The rule named after the field is used if present, otherwise the one
+//! of its group, e.g. "power" for all circuits. Missing thresholds are 0,
+//! which writes every change.
+//! \param conf configuration.
+//! \param field field name.
+//! \param group group of the field.
+//! \return Band of the field.
+Deadband::Rule readDeadbandRule(Configuration& conf, const std::string& field, const std::string& group);
+
+} /* namespace PowerMonitor */
+
+#endif /* DEADBAND_H_ */
@@ -8,7 +8,12 @@
 #ifndef DELAY_H_
 #define DELAY_H_
 
-#include <queue>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
 
 namespace PowerMonitor
 {
@@ -20,15 +25,20 @@ namespace PowerMonitor
 //! low frequencies is n = f_s / (pi * f_c), where f_c is the cutoff frequency
 //! of the low-pass filter and f_s the sampling rate.
 //!
-template<class T> class Delay
+//! The delayed values are kept in a contiguous ring buffer which starts out
+//! filled with zeros. When N is non-zero the length is fixed at compile time
+//! and the buffer is stored inline, otherwise it is allocated once on
+//! construction.
+//!
+template<class T, unsigned int N = 0> class Delay
 {
 public:
     //! Constructor.
-    //! \param n delay in number of samples.
-    Delay(unsigned int n)
+    //! \param n delay in number of samples, must equal N if N is non-zero.
+    Delay(unsigned int n = N) :
+            _position(0)
     {
-        for (unsigned int i = 0; i < n; ++i)
-            _buffer.emplace();
+        _init(_buffer, n);
     }
 
     //! Delays signal.
@@ -36,13 +46,157 @@ public:
     //! \return Delayed sample.
     T operator()(const T sample)
     {
-        T value = _buffer.front();
-        _buffer.pop();
-        _buffer.push(sample);
+        if (_buffer.size() == 0)
+            return sample;
+        T value = _buffer[_position];
+        _buffer[_position] = sample;
+        if (++_position == _buffer.size())
+            _position = 0;
         return value;
     }
+
+    //! Delays a block of samples.
+    //! \param in next samples in the signal.
+    //! \param out delayed samples, may be the same as in.
+    //! \param n number of samples.
+    void process(const T* in, T* out, size_t n)
+    {
+        const size_t length = _buffer.size();
+        if (length == 0)
+        {
+            if (in != out)
+                std::copy(in, in + n, out);
+            return;
+        }
+        while (n > 0)
+        {
+            // Process up to the end of the ring without wrapping.
+            size_t count = std::min(n, length - _position);
+            T* ring = &_buffer[_position];
+            for (size_t i = 0; i < count; ++i)
+            {
+                T value = ring[i];
+                ring[i] = in[i];
+                out[i] = value;
+            }
+            in += count;
+            out += count;
+            n -= count;
+            _position += count;
+            if (_position == length)
+                _position = 0;
+        }
+    }
+
 private:
-    std::queue<T> _buffer; //!< Buffer to hold the delayed values.
+    typedef typename std::conditional<N == 0, std::vector<T>, std::array<T, N> >::type Buffer;
+
+    static void _init(std::vector<T>& buffer, unsigned int n)
+    {
+        buffer.assign(n, T());
+    }
+    static void _init(std::array<T, N>& buffer, unsigned int n)
+    {
+        if (n != N)
+            throw std::invalid_argument("Delay length does not match compile-time length.");
+        buffer.fill(T());
+    }
+
+    Buffer _buffer;         //!< Ring buffer to hold the delayed values.
+    size_t _position;       //!< Position of the oldest value in the buffer.
+};
+
+//! Bank of delay lines of different lengths.
+//!
+//! Keeps the rings of all lanes in one contiguous buffer, so a pipeline
+//! with many channels has its delay state in a single allocation. Each
+//! lane behaves exactly like a Delay of the same length.
+//!
+template<class T> class DelayBank
+{
+public:
+    //! Constructor.
+    //! \param lengths delay of each lane in number of samples.
+    DelayBank(const std::vector<unsigned int>& lengths) :
+            _lanes(lengths.size())
+    {
+        size_t offset = 0;
+        for (size_t l = 0; l < lengths.size(); ++l)
+        {
+            _lanes[l].offset = offset;
+            _lanes[l].length = lengths[l];
+            _lanes[l].position = 0;
+            offset += lengths[l];
+        }
+        _buffer.assign(offset, T());
+    }
+
+    //! Gets the number of lanes.
+    unsigned int lanes() const
+    {
+        return _lanes.size();
+    }
+
+    //! Delays one sample of one lane.
+    //! \param lane lane index.
+    //! \param sample next sample in the lane.
+    //! \return Delayed sample.
+    T operator()(unsigned int lane, const T sample)
+    {
+        Lane& state = _lanes[lane];
+        if (state.length == 0)
+            return sample;
+        T& slot = _buffer[state.offset + state.position];
+        T value = slot;
+        slot = sample;
+        if (++state.position == state.length)
+            state.position = 0;
+        return value;
+    }
+
+    //! Delays a block of samples of one lane in place.
+    //! \param lane lane index.
+    //! \param data samples to delay.
+    //! \param n number of samples.
+    void process(unsigned int lane, T* data, size_t n)
+    {
+        Lane& state = _lanes[lane];
+        const size_t length = state.length;
+        if (length == 0)
+            return;
+        T* buffer = &_buffer[state.offset];
+        size_t position = state.position;
+        while (n > 0)
+        {
+            // Process up to the end of the ring without wrapping.
+            size_t count = std::min(n, length - position);
+            T* ring = buffer + position;
+            for (size_t i = 0; i < count; ++i)
+            {
+                T value = ring[i];
+                ring[i] = data[i];
+                data[i] = value;
+            }
+            data += count;
+            n -= count;
+            position += count;
+            if (position == length)
+                position = 0;
+        }
+        state.position = position;
+    }
+
+private:
+    //! Ring of one lane.
+    struct Lane
+    {
+        size_t offset;      //!< Start of the ring in the buffer.
+        size_t length;      //!< Delay in samples.
+        size_t position;    //!< Position of the oldest value in the ring.
+    };
+
+    std::vector<Lane> _lanes;   //!< Per-lane rings.
+    std::vector<T> _buffer;     //!< Rings of all lanes.
 };
 
 } /* namespace PowerMonitor */
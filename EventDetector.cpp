@@ -0,0 +1,273 @@
+/*
+ * EventDetector.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <new>
+#include <stdexcept>
+#include "Capture.h"
+#include "Configuration.h"
+#include "EventDetector.h"
+
+namespace PowerMonitor
+{
+
+static const char* const KIND_NAMES[] = { "sag", "swell", "inrush" };
+
+static void base64(const char* data, size_t size, std::string& out)
+{
+    static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    out.clear();
+    out.reserve((size + 2) / 3 * 4);
+    for (size_t i = 0; i < size; i += 3)
+    {
+        uint32_t v = (uint32_t) (unsigned char) data[i] << 16;
+        if (i + 1 < size)
+            v |= (uint32_t) (unsigned char) data[i + 1] << 8;
+        if (i + 2 < size)
+            v |= (unsigned char) data[i + 2];
+        out += digits[v >> 18];
+        out += digits[(v >> 12) & 63];
+        out += i + 1 < size ? digits[(v >> 6) & 63] : '=';
+        out += i + 2 < size ? digits[v & 63] : '=';
+    }
+}
+
+EventDetector::EventDetector(unsigned int sampleRate, unsigned int mainsFreq, unsigned int blockSize,
+        const std::vector<std::string>& names, const Options& options, InfluxdbWriter* influx) :
+        _sampleRate(sampleRate),
+        _halfCycle(sampleRate / (2 * mainsFreq)),
+        _halfPosition(0),
+        _pre(options.preCycles * sampleRate / mainsFreq),
+        _post(std::max(1u, options.postCycles) * sampleRate / mainsFreq),
+        _options(options),
+        _names(names),
+        _ringSize(_pre + _post + blockSize),
+        _written(0),
+        _records(std::max(1u, options.queueSize),
+                EventRecord { EventRecord::Sag, 0, 0, 0.f, 0.f, false, 0, SampleBlock(names.size(), _pre + _post) }),
+        _influx(influx),
+        _stop(false),
+        _dropped(0)
+{
+    if (_halfCycle == 0)
+        throw std::runtime_error("Sampling rate too low for half-cycle RMS.");
+    for (unsigned int c = 0; c < names.size(); ++c)
+    {
+        Channel ch = { 0.f, 0.f, 0.0, 0.0, false, EventRecord::Sag };
+        if (c == 0)
+        {
+            ch.low = options.sag;
+            ch.high = options.swell;
+        }
+        else
+            ch.high = options.inrush;
+        _channels.push_back(ch);
+    }
+    _ring.resize(_channels.size() * _ringSize);
+    _capture.active = false;
+    _thread = std::thread(&EventDetector::_run, this);
+}
+
+EventDetector::~EventDetector()
+{
+    _stop = true;
+    _thread.join();
+}
+
+void* EventDetector::operator new(size_t size)
+{
+    void* p;
+    if (posix_memalign(&p, alignof(EventDetector), size) != 0)
+        throw std::bad_alloc();
+    return p;
+}
+
+void EventDetector::operator delete(void* p)
+{
+    free(p);
+}
+
+void EventDetector::_store(const SampleBlock& block)
+{
+    const size_t position = _written % _ringSize;
+    const size_t first = std::min(block.size, _ringSize - position);
+    for (unsigned int c = 0; c < _channels.size(); ++c)
+    {
+        int16_t* ring = &_ring[c * _ringSize];
+        memcpy(ring + position, block.channel(c), first * sizeof(int16_t));
+        memcpy(ring, block.channel(c) + first, (block.size - first) * sizeof(int16_t));
+    }
+}
+
+void EventDetector::_check(unsigned int c, float rms, size_t index, const SampleBlock& block)
+{
+    Channel& ch = _channels[c];
+    const unsigned long long sample = _written + index;
+    // Let the high-pass filters and the first full cycle settle.
+    if (sample < _sampleRate)
+        return;
+    if (ch.beyond)
+    {
+        bool back = ch.kind == EventRecord::Sag ? rms > ch.low * (1.f + _options.hysteresis)
+                : rms < ch.high * (1.f - _options.hysteresis);
+        if (_capture.active && _capture.channel == c && _capture.end == 0)
+        {
+            _capture.extreme = ch.kind == EventRecord::Sag ? std::min(_capture.extreme, rms)
+                    : std::max(_capture.extreme, rms);
+            if (back)
+                _capture.end = sample;
+        }
+        ch.beyond = !back;
+        return;
+    }
+    if (ch.low > 0.f && rms < ch.low)
+        ch.kind = EventRecord::Sag;
+    else if (ch.high > 0.f && rms > ch.high)
+        ch.kind = c == 0 ? EventRecord::Swell : EventRecord::Inrush;
+    else
+        return;
+    ch.beyond = true;
+    // Events during a capture are in its waveform already.
+    if (_capture.active)
+        return;
+    _capture.active = true;
+    _capture.kind = ch.kind;
+    _capture.channel = c;
+    _capture.trigger = sample;
+    _capture.timestamp = block.timestamp - (long long) ((block.size - 1 - index) * 1000000000ULL / _sampleRate);
+    _capture.extreme = rms;
+    _capture.end = 0;
+}
+
+void EventDetector::_complete(const SampleBlock& block)
+{
+    if (!_capture.active || _written < _capture.trigger + _post)
+        return;
+    _capture.active = false;
+    EventRecord* record = _records.acquireWrite();
+    if (record == nullptr)
+    {
+        _dropped++;
+        return;
+    }
+    // Samples from before the start or already overwritten are not available.
+    unsigned long long start = _capture.trigger >= _pre ? _capture.trigger - _pre : 0;
+    start = std::max(start, _written > _ringSize ? _written - _ringSize : 0ULL);
+    const unsigned long long end = _capture.trigger + _post;
+    const size_t frames = end - start;
+    const size_t position = start % _ringSize;
+    const size_t first = std::min(frames, _ringSize - position);
+    SampleBlock& samples = record->samples;
+    for (unsigned int c = 0; c < _channels.size(); ++c)
+    {
+        const int16_t* ring = &_ring[c * _ringSize];
+        memcpy(samples.channel(c), ring + position, first * sizeof(int16_t));
+        memcpy(samples.channel(c) + first, ring, (frames - first) * sizeof(int16_t));
+    }
+    std::copy(block.scale.begin(), block.scale.end(), samples.scale.begin());
+    std::copy(block.offset.begin(), block.offset.end(), samples.offset.begin());
+    samples.size = frames;
+    samples.timestamp = _capture.timestamp + (long long) ((end - 1 - _capture.trigger) * 1000000000ULL / _sampleRate);
+    record->kind = _capture.kind;
+    record->channel = _capture.channel;
+    record->timestamp = _capture.timestamp;
+    record->extreme = _capture.extreme;
+    record->ongoing = _capture.end == 0;
+    record->duration = (double) ((record->ongoing ? end : _capture.end) - _capture.trigger) / _sampleRate;
+    record->pretrigger = _capture.trigger - start;
+    _records.commitWrite();
+}
+
+void EventDetector::_run()
+{
+    for (;;)
+    {
+        // Events are rare, polling keeps the measurement thread free of any waking.
+        bool stop = _stop;
+        EventRecord* record;
+        while ((record = _records.acquireRead()) != nullptr)
+        {
+            try
+            {
+                _writeRecord(*record);
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << e.what() << std::endl;
+            }
+            _records.releaseRead();
+        }
+        if (stop)
+            return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
+
+void EventDetector::_writeRecord(const EventRecord& record)
+{
+    const char* kind = KIND_NAMES[record.kind];
+    const std::string& channel = _names[record.channel];
+    std::string path;
+    if (!_options.directory.empty())
+    {
+        path = _options.directory + "/event-" + std::to_string(record.timestamp) + "-" + kind + "-" + channel
+                + ".pmcapt";
+        CaptureWriter writer(path, _channels.size(), _sampleRate);
+        writer.write(record.samples);
+    }
+    if (_influx == nullptr)
+        return;
+
+    // The point carries the same capture file, so it can be replayed as well.
+    char* data = nullptr;
+    size_t size = 0;
+    FILE* file = open_memstream(&data, &size);
+    if (file == nullptr)
+        throw std::runtime_error("Could not encode event.");
+    {
+        CaptureWriter writer(file, _channels.size(), _sampleRate);
+        writer.write(record.samples);
+    }
+    std::string waveform;
+    base64(data, size, waveform);
+    free(data);
+
+    LineProtocol::Prefix prefix("event", std::map<std::string, std::string> { { "kind", kind }, { "channel", channel } });
+    _lines.clear();
+    _lines.begin(prefix)
+            .field("extreme", record.extreme)
+            .field("duration", record.duration)
+            .field("ongoing", record.ongoing)
+            .field("pretrigger", (long long) record.pretrigger)
+            .field("frames", (long long) record.samples.size);
+    if (!path.empty())
+        _lines.field("file", path);
+    _lines.field("waveform", waveform);
+    _lines.end(record.timestamp);
+    _influx->write(_lines);
+}
+
+EventDetector::Options readEventOptions(Configuration& conf)
+{
+    EventDetector::Options options;
+    options.sag = conf.get("PowerMonitor.events.sag", options.sag);
+    options.swell = conf.get("PowerMonitor.events.swell", options.swell);
+    options.inrush = conf.get("PowerMonitor.events.inrush", options.inrush);
+    options.hysteresis = conf.get("PowerMonitor.events.hysteresis", options.hysteresis);
+    options.preCycles = conf.get("PowerMonitor.events.pre", options.preCycles);
+    options.postCycles = conf.get("PowerMonitor.events.post", options.postCycles);
+    options.queueSize = conf.get("PowerMonitor.events.queue", options.queueSize);
+    options.directory = conf.get("PowerMonitor.events.directory", options.directory);
+    return options;
+}
+
+} /* namespace PowerMonitor */
@@ -0,0 +1,207 @@
+/*
+ * EventDetector.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef EVENTDETECTOR_H_
+#define EVENTDETECTOR_H_
+
+#include <atomic>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BlockProcessor.h"
+#include "InfluxdbWriter.h"
+#include "SampleBlock.h"
+#include "SpscRing.h"
+
+namespace PowerMonitor
+{
+
+class Configuration;
+
+//! Power quality event with its frozen waveform.
+struct EventRecord
+{
+    //! Kind of event.
+    enum Kind
+    {
+        Sag,        //!< Voltage below the sag threshold.
+        Swell,      //!< Voltage above the swell threshold.
+        Inrush      //!< Current above the inrush threshold.
+    };
+
+    Kind            kind;           //!< Kind of event.
+    unsigned int    channel;        //!< Channel that tripped, 0 for the voltage.
+    long long       timestamp;      //!< Time of the trigger in nanoseconds since Unix epoch.
+    float           extreme;        //!< Lowest (sag) or highest half-cycle RMS during the capture.
+    float           duration;       //!< Seconds beyond the threshold.
+    bool            ongoing;        //!< Still beyond the threshold at the end of the capture?
+    unsigned int    pretrigger;     //!< Frames before the trigger.
+    SampleBlock     samples;        //!< Raw samples of all channels around the trigger.
+};
+
+//! Detects voltage sags, swells and current inrush on half-cycle RMS values.
+//!
+//! The RMS over one mains cycle is updated every half cycle, as in
+//! IEC 61000-4-30, from the filtered signals of the block processor:
+//! one running sum of squares per channel, so O(1) per sample. Half cycles
+//! are counted in samples and not aligned to zero crossings. The first
+//! second is ignored while the high-pass filters settle.
+//!
+//! The raw samples of all channels go into a ring. When a threshold
+//! trips, the given number of cycles before and after the trigger are
+//! frozen into a preallocated record, together with the extreme RMS and
+//! the duration. Only one event is captured at a time. The measurement
+//! thread only copies; a background thread writes the records to a
+//! capture file each, which powermon --replay can read, and/or as an
+//! "event" point with the capture file base64 encoded. If the writer
+//! falls behind, events are dropped and counted.
+//!
+class EventDetector
+{
+public:
+    //! Detector settings.
+    struct Options
+    {
+        Options() :
+            sag(207.f),
+            swell(253.f),
+            inrush(0.f),
+            hysteresis(0.02f),
+            preCycles(5),
+            postCycles(10),
+            queueSize(4)
+        {
+        }
+        float sag;                  //!< Sag threshold in volts, 0 to disable.
+        float swell;                //!< Swell threshold in volts, 0 to disable.
+        float inrush;               //!< Current threshold in amperes, 0 to disable.
+        float hysteresis;           //!< Relative hysteresis for the end of an event.
+        unsigned int preCycles;     //!< Mains cycles kept before the trigger.
+        unsigned int postCycles;    //!< Mains cycles captured after the trigger.
+        unsigned int queueSize;     //!< Records waiting for the writer.
+        std::string directory;      //!< Directory for capture files, empty for none.
+    };
+
+    //! Constructor, starts the writer thread.
+    //! \param sampleRate sampling rate in Hz.
+    //! \param mainsFreq nominal mains frequency in Hz.
+    //! \param blockSize maximum number of samples per channel in a block.
+    //! \param names channel names, the voltage first.
+    //! \param options detector settings.
+    //! \param influx writer for event points, nullptr for none.
+    EventDetector(unsigned int sampleRate, unsigned int mainsFreq, unsigned int blockSize,
+            const std::vector<std::string>& names, const Options& options, InfluxdbWriter* influx);
+    //! Destructor, writes the queued records and stops the writer thread.
+    ~EventDetector();
+
+    //! Allocates with the cache line alignment of the record ring.
+    static void* operator new(size_t size);
+    static void operator delete(void* p);
+
+    //! Processes a block.
+    //! \param block raw samples of the block.
+    //! \param processor processor that has just processed the block.
+    template<class T> void process(const SampleBlock& block, const BlockProcessor<T>& processor)
+    {
+        _store(block);
+        for (unsigned int c = 0; c < _channels.size(); ++c)
+            _detect(c, processor.signal(c).data(), processor.blockSize(),
+                    processor.unitScale(c) * processor.unitScale(c), block);
+        _written += block.size;
+        _complete(block);
+    }
+
+    //! Gets the number of events dropped because the writer fell behind.
+    unsigned long long dropped() const
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    EventDetector(const EventDetector&);
+    EventDetector& operator=(const EventDetector&);
+
+    //! Detection state of one channel.
+    struct Channel
+    {
+        float               low;        //!< Trips below, 0 for never.
+        float               high;       //!< Trips above, 0 for never.
+        double              previous;   //!< Sum of squares of the previous half cycle.
+        double              current;    //!< Sum of squares of the current half cycle.
+        bool                beyond;     //!< Beyond a threshold?
+        EventRecord::Kind   kind;       //!< Which one, while beyond.
+    };
+
+    //! Event being captured.
+    struct Capture
+    {
+        bool                active;     //!< Capturing?
+        EventRecord::Kind   kind;       //!< Kind of event.
+        unsigned int        channel;    //!< Channel that tripped.
+        unsigned long long  trigger;    //!< Sample number of the trigger.
+        long long           timestamp;  //!< Time of the trigger.
+        float               extreme;    //!< Extreme RMS so far.
+        unsigned long long  end;        //!< Sample number of the end of the event, 0 while ongoing.
+    };
+
+    template<class T> void _detect(unsigned int c, const T* x, size_t count, double scale2,
+            const SampleBlock& block)
+    {
+        Channel& ch = _channels[c];
+        double sum = ch.current;
+        size_t n = _halfPosition;
+        for (size_t i = 0; i < count; ++i)
+        {
+            sum += (double) x[i] * x[i];
+            if (++n == _halfCycle)
+            {
+                float rms = std::sqrt((ch.previous + sum) * scale2 / (2 * _halfCycle));
+                ch.previous = sum;
+                sum = 0.0;
+                n = 0;
+                _check(c, rms, i, block);
+            }
+        }
+        ch.current = sum;
+        if (c + 1 == _channels.size())
+            _halfPosition = n;
+    }
+
+    void _check(unsigned int c, float rms, size_t index, const SampleBlock& block);
+    void _store(const SampleBlock& block);
+    void _complete(const SampleBlock& block);
+    void _run();
+    void _writeRecord(const EventRecord& record);
+
+    unsigned int                _sampleRate;        //!< Sampling rate in Hz.
+    size_t                      _halfCycle;         //!< Samples per half cycle.
+    size_t                      _halfPosition;      //!< Samples in the current half cycle.
+    size_t                      _pre;               //!< Samples kept before the trigger.
+    size_t                      _post;              //!< Samples captured after the trigger.
+    Options                     _options;           //!< Settings.
+    std::vector<std::string>    _names;             //!< Channel names.
+    std::vector<Channel>        _channels;          //!< Per-channel detection state.
+    std::vector<int16_t>        _ring;              //!< Raw samples, one ring per channel.
+    size_t                      _ringSize;          //!< Samples per channel in the ring.
+    unsigned long long          _written;           //!< Samples per channel stored so far.
+    Capture                     _capture;           //!< Event being captured.
+    SpscRing<EventRecord>       _records;           //!< Records for the writer thread.
+    InfluxdbWriter*             _influx;            //!< Writer for event points.
+    LineProtocol                _lines;             //!< Event point, writer thread only.
+    std::atomic<bool>           _stop;              //!< Stop the writer thread?
+    std::atomic<unsigned long long> _dropped;       //!< Events not captured.
+    std::thread                 _thread;            //!< Writer thread.
+};
+
+//! Reads the event detector settings from PowerMonitor.events.
+//! \param conf configuration.
+//! \return Settings.
+EventDetector::Options readEventOptions(Configuration& conf);
+
+} /* namespace PowerMonitor */
+
+#endif /* EVENTDETECTOR_H_ */
@@ -0,0 +1,386 @@
+/*
+ * FilterBank.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef FILTERBANK_H_
+#define FILTERBANK_H_
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include "HighPassFilter.h"
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+namespace PowerMonitor
+{
+
+//! Bank of identical first-order IIR high-pass filters.
+//!
+//! Runs the HighPassFilter recursion for several independent channels
+//! (lanes) at once. The recursion is serial in time, so the lanes of one
+//! time step are processed side by side, four at a time in SSE registers
+//! for float. Each lane gives exactly the same output as a HighPassFilter
+//! with the same parameters, including passing the first sample through.
+//! Integer samples use the fixed-point arithmetic of HighPassFilterTraits.
+//!
+template<class T> class HighPassFilterBank
+{
+public:
+    typedef HighPassFilterTraits<T> Traits;
+
+    //! Constructor.
+    //! \param lanes number of channels.
+    //! \param dt time step in s.
+    //! \param f crossover frequency in Hz.
+    HighPassFilterBank(unsigned int lanes, double dt, double f) :
+            _alpha(Traits::coefficient(1.0 / (1.0 + 6.283185307 * f * dt))),
+            _previousSample(lanes),
+            _previousResult(lanes),
+            _initialized(false)
+    {
+    }
+
+    //! Gets the number of channels.
+    unsigned int lanes() const
+    {
+        return _previousSample.size();
+    }
+
+    //! Filters one sample of every channel in place.
+    //! \param frame one sample per channel.
+    void operator()(T* frame)
+    {
+        const unsigned int n = lanes();
+        T* ps = _previousSample.data();
+        T* pr = _previousResult.data();
+        if (!_initialized)
+        {
+            for (unsigned int l = 0; l < n; ++l)
+            {
+                pr[l] = frame[l];
+                ps[l] = frame[l];
+            }
+            _initialized = true;
+            return;
+        }
+        unsigned int l = _step(frame, ps, pr, n);
+        for (; l < n; ++l)
+        {
+            T sample = frame[l];
+            T result = Traits::multiply(_alpha, pr[l] + sample - ps[l]);
+            pr[l] = result;
+            ps[l] = sample;
+            frame[l] = result;
+        }
+    }
+
+    //! Filters interleaved samples in place.
+    //! \param data frames of lanes() samples each.
+    //! \param frames number of frames.
+    void process(T* data, size_t frames)
+    {
+        const unsigned int n = lanes();
+        for (size_t i = 0; i < frames; ++i, data += n)
+            (*this)(data);
+    }
+
+    //! Filters samples stored one array per channel in place.
+    //!
+    //! Runs the recursion over each channel's contiguous samples in turn,
+    //! with the same result as filtering frame by frame.
+    //! \param channels lanes() arrays of samples.
+    //! \param count number of samples per channel.
+    void process(T* const* channels, size_t count)
+    {
+        if (count == 0)
+            return;
+        const unsigned int n = lanes();
+        for (unsigned int l = 0; l < n; ++l)
+        {
+            T* data = channels[l];
+            size_t i = 0;
+            if (!_initialized)
+            {
+                _previousSample[l] = data[0];
+                _previousResult[l] = data[0];
+                i = 1;
+            }
+            T previous = _previousSample[l];
+            T result = _previousResult[l];
+            for (; i < count; ++i)
+            {
+                T sample = data[i];
+                result = Traits::multiply(_alpha, result + sample - previous);
+                previous = sample;
+                data[i] = result;
+            }
+            _previousSample[l] = previous;
+            _previousResult[l] = result;
+        }
+        _initialized = true;
+    }
+
+private:
+    //! Vectorized part of one time step.
+    //! \return Number of lanes processed.
+    unsigned int _step(T*, T*, T*, unsigned int)
+    {
+        return 0;
+    }
+
+    typename Traits::Coefficient _alpha;    //!< Filter coefficient.
+    std::vector<T> _previousSample;     //!< Previous sample per channel.
+    std::vector<T> _previousResult;     //!< Previous filtered sample per channel.
+    bool _initialized;                  //!< Previous samples initialized?
+};
+
+#if defined(__SSE__)
+template<> inline unsigned int HighPassFilterBank<float>::_step(float* frame, float* ps, float* pr, unsigned int n)
+{
+    const __m128 alpha = _mm_set1_ps(_alpha);
+    unsigned int l = 0;
+    for (; l + 4 <= n; l += 4)
+    {
+        __m128 sample = _mm_loadu_ps(frame + l);
+        __m128 result = _mm_mul_ps(alpha,
+                _mm_sub_ps(_mm_add_ps(_mm_loadu_ps(pr + l), sample), _mm_loadu_ps(ps + l)));
+        _mm_storeu_ps(pr + l, result);
+        _mm_storeu_ps(ps + l, sample);
+        _mm_storeu_ps(frame + l, result);
+    }
+    return l;
+}
+#endif
+
+//! Second-order IIR section coefficients, normalized so that a0 = 1.
+template<class T> struct Biquad
+{
+    T b0, b1, b2, a1, a2;
+
+    //! First-order high-pass section equal to HighPassFilter.
+    //! \param dt time step in s.
+    //! \param f crossover frequency in Hz.
+    static Biquad firstOrderHighPass(double dt, double f)
+    {
+        double alpha = 1.0 / (1.0 + 6.283185307 * f * dt);
+        Biquad b = { (T) alpha, (T) -alpha, 0, (T) -alpha, 0 };
+        return b;
+    }
+
+    //! Second-order high-pass section (bilinear transform).
+    //! \param dt time step in s.
+    //! \param f cutoff frequency in Hz.
+    //! \param q quality factor.
+    static Biquad highPass(double dt, double f, double q)
+    {
+        double w0 = 6.283185307179586 * f * dt;
+        double cw = std::cos(w0);
+        double alpha = std::sin(w0) / (2.0 * q);
+        double a0 = 1.0 + alpha;
+        Biquad b = {
+            (T) ((1.0 + cw) / 2.0 / a0),
+            (T) (-(1.0 + cw) / a0),
+            (T) ((1.0 + cw) / 2.0 / a0),
+            (T) (-2.0 * cw / a0),
+            (T) ((1.0 - alpha) / a0)
+        };
+        return b;
+    }
+
+    //! Butterworth high-pass (DC blocking) filter as a cascade of sections.
+    //! \param order filter order, odd orders add a first-order section.
+    //! \param dt time step in s.
+    //! \param f cutoff frequency in Hz.
+    static std::vector<Biquad> butterworthHighPass(unsigned int order, double dt, double f)
+    {
+        std::vector<Biquad> sections;
+        for (unsigned int k = 1; k <= order / 2; ++k)
+        {
+            double theta = (2.0 * k - 1.0) * 3.141592653589793 / (2.0 * order);
+            sections.push_back(highPass(dt, f, 1.0 / (2.0 * std::cos(theta))));
+        }
+        if (order % 2)
+        {
+            // Bilinear transform of a first-order high-pass.
+            double k = std::tan(3.141592653589793 * f * dt);
+            double a0 = 1.0 + k;
+            Biquad b = { (T) (1.0 / a0), (T) (-1.0 / a0), 0, (T) ((k - 1.0) / a0), 0 };
+            sections.push_back(b);
+        }
+        return sections;
+    }
+};
+
+//! Bank of identical cascaded biquad IIR filters.
+//!
+//! Runs a cascade of second-order sections in transposed direct form II
+//! for several channels (lanes) at once. As with HighPassFilter, the first
+//! sample of each channel passes through unchanged and seeds the state as
+//! if the input and output had been constant at that value, so a DC offset
+//! decays from the first sample instead of causing a step transient.
+//! Low cutoff frequencies put the poles very close to the unit circle,
+//! which float still handles at a 1 Hz cutoff at 2100 Hz; use double well
+//! below that. The lanes of one section are processed four at a time in
+//! SSE registers for float.
+//!
+//! For floating point samples only: the coefficients of a section reach 2
+//! in magnitude, beyond the Q30 coefficients of HighPassFilterTraits, and
+//! fixed-point state near the unit circle would need far more resolution.
+//!
+template<class T> class BiquadFilterBank
+{
+public:
+    //! Constructor.
+    //! \param lanes number of channels.
+    //! \param sections filter sections applied in order.
+    BiquadFilterBank(unsigned int lanes, const std::vector<Biquad<T> >& sections) :
+            _lanes(lanes),
+            _sections(sections),
+            _s1(lanes * sections.size()),
+            _s2(lanes * sections.size()),
+            _initialized(false)
+    {
+        if (sections.empty())
+            throw std::invalid_argument("Filter bank needs at least one section.");
+    }
+
+    //! Gets the number of channels.
+    unsigned int lanes() const
+    {
+        return _lanes;
+    }
+
+    //! Filters one sample of every channel in place.
+    //! \param frame one sample per channel.
+    void operator()(T* frame)
+    {
+        if (!_initialized)
+        {
+            _seed(frame);
+            return;
+        }
+        for (size_t s = 0; s < _sections.size(); ++s)
+        {
+            const Biquad<T> c = _sections[s];
+            T* s1 = &_s1[s * _lanes];
+            T* s2 = &_s2[s * _lanes];
+            for (unsigned int l = _step(c, frame, s1, s2); l < _lanes; ++l)
+            {
+                T x = frame[l];
+                T y = c.b0 * x + s1[l];
+                s1[l] = c.b1 * x - c.a1 * y + s2[l];
+                s2[l] = c.b2 * x - c.a2 * y;
+                frame[l] = y;
+            }
+        }
+    }
+
+    //! Filters interleaved samples in place.
+    //! \param data frames of lanes() samples each.
+    //! \param frames number of frames.
+    void process(T* data, size_t frames)
+    {
+        for (size_t i = 0; i < frames; ++i, data += _lanes)
+            (*this)(data);
+    }
+
+    //! Filters samples stored one array per channel in place.
+    //!
+    //! Runs the cascade over each channel's contiguous samples in turn,
+    //! with the same result as filtering frame by frame.
+    //! \param channels lanes() arrays of samples.
+    //! \param count number of samples per channel.
+    void process(T* const* channels, size_t count)
+    {
+        if (count == 0)
+            return;
+        const size_t sections = _sections.size();
+        for (unsigned int l = 0; l < _lanes; ++l)
+        {
+            T* data = channels[l];
+            size_t i = 0;
+            if (!_initialized)
+            {
+                _seed(l, data[0]);
+                i = 1;
+            }
+            for (; i < count; ++i)
+            {
+                T x = data[i];
+                for (size_t s = 0; s < sections; ++s)
+                {
+                    const Biquad<T>& c = _sections[s];
+                    T& s1 = _s1[s * _lanes + l];
+                    T& s2 = _s2[s * _lanes + l];
+                    T y = c.b0 * x + s1;
+                    s1 = c.b1 * x - c.a1 * y + s2;
+                    s2 = c.b2 * x - c.a2 * y;
+                    x = y;
+                }
+                data[i] = x;
+            }
+        }
+        _initialized = true;
+    }
+
+private:
+    //! Seeds the state of every lane as if constant at its first sample.
+    void _seed(const T* frame)
+    {
+        for (unsigned int l = 0; l < _lanes; ++l)
+            _seed(l, frame[l]);
+        _initialized = true;
+    }
+
+    //! Seeds the state of one lane as if constant at x.
+    void _seed(unsigned int l, T x)
+    {
+        for (size_t s = 0; s < _sections.size(); ++s)
+        {
+            const Biquad<T>& c = _sections[s];
+            _s2[s * _lanes + l] = (c.b2 - c.a2) * x;
+            _s1[s * _lanes + l] = (c.b1 - c.a1) * x + _s2[s * _lanes + l];
+        }
+    }
+
+    //! Vectorized part of one section.
+    //! \return Number of lanes processed.
+    unsigned int _step(const Biquad<T>&, T*, T*, T*)
+    {
+        return 0;
+    }
+
+    unsigned int _lanes;                    //!< Number of channels.
+    std::vector<Biquad<T> > _sections;      //!< Filter sections.
+    std::vector<T> _s1;                     //!< First state per section and channel.
+    std::vector<T> _s2;                     //!< Second state per section and channel.
+    bool _initialized;                      //!< State initialized?
+};
+
+#if defined(__SSE__)
+template<> inline unsigned int BiquadFilterBank<float>::_step(const Biquad<float>& c, float* frame, float* s1, float* s2)
+{
+    const __m128 b0 = _mm_set1_ps(c.b0), b1 = _mm_set1_ps(c.b1), b2 = _mm_set1_ps(c.b2);
+    const __m128 a1 = _mm_set1_ps(c.a1), a2 = _mm_set1_ps(c.a2);
+    unsigned int l = 0;
+    for (; l + 4 <= _lanes; l += 4)
+    {
+        // Same operations in the same order as the scalar loop.
+        __m128 x = _mm_loadu_ps(frame + l);
+        __m128 y = _mm_add_ps(_mm_mul_ps(b0, x), _mm_loadu_ps(s1 + l));
+        _mm_storeu_ps(s1 + l, _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), _mm_loadu_ps(s2 + l)));
+        _mm_storeu_ps(s2 + l, _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y)));
+        _mm_storeu_ps(frame + l, y);
+    }
+    return l;
+}
+#endif
+
+} /* namespace PowerMonitor */
+
+#endif /* FILTERBANK_H_ */
@@ -0,0 +1,121 @@
+/*
+ * FrequencyEstimator.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef FREQUENCYESTIMATOR_H_
+#define FREQUENCYESTIMATOR_H_
+
+namespace PowerMonitor
+{
+
+//! Streaming per-cycle frequency estimator.
+//!
+//! Detects rising zero crossings and interpolates their position linearly
+//! between the two samples around zero, so the period is resolved to a
+//! fraction of a sample. A crossing only counts after the signal has been
+//! below -hysteresis since the previous crossing and at least holdoff
+//! samples have passed, which rejects the extra crossings noise causes
+//! near zero. Constant work per sample. Integer samples are compared as
+//! integers; floating point is only used when a crossing is found.
+//!
+template<class T = float> class FrequencyEstimator
+{
+public:
+    //! Constructor.
+    //! \param sampleRate sampling rate in Hz.
+    //! \param hysteresis level the signal must drop below to arm detection.
+    //! \param holdoff minimum number of samples between crossings, e.g. three quarters of a cycle.
+    FrequencyEstimator(unsigned int sampleRate, T hysteresis, unsigned int holdoff = 0) :
+            _sampleRate(sampleRate),
+            _hysteresis(hysteresis),
+            _holdoff(holdoff),
+            _index(0),
+            _previous(0),
+            _armed(false),
+            _haveCrossing(false),
+            _lastCrossing(0.0),
+            _frequency(0.f),
+            _periods(0.0),
+            _cycles(0)
+    {
+    }
+
+    //! Feeds one sample.
+    //! \param sample next sample.
+    //! \return True if a cycle was completed.
+    bool operator()(T sample)
+    {
+        bool completed = false;
+        if (sample < -_hysteresis)
+            _armed = !_haveCrossing || _index - _lastCrossing >= _holdoff;
+        else if (_armed && sample >= 0 && _previous < 0)
+        {
+            double crossing = (_index - 1) + (double) _previous / (_previous - sample);
+            if (_haveCrossing)
+            {
+                double period = crossing - _lastCrossing;
+                _frequency = _sampleRate / period;
+                _periods += period;
+                _cycles++;
+                completed = true;
+            }
+            _lastCrossing = crossing;
+            _haveCrossing = true;
+            _armed = false;
+        }
+        _previous = sample;
+        _index++;
+        return completed;
+    }
+
+    //! Sets the level the signal must drop below to arm detection.
+    void setHysteresis(T hysteresis)
+    {
+        _hysteresis = hysteresis;
+    }
+
+    //! Gets the frequency of the last complete cycle in Hz.
+    float frequency() const
+    {
+        return _frequency;
+    }
+
+    //! Gets the average frequency of the cycles completed since reset().
+    //! \return Frequency in Hz, or the last cycle if none completed.
+    float average() const
+    {
+        return _cycles ? _sampleRate * _cycles / _periods : _frequency;
+    }
+
+    //! Gets the number of cycles completed since reset().
+    unsigned int cycles() const
+    {
+        return _cycles;
+    }
+
+    //! Starts a new averaging window.
+    void reset()
+    {
+        _periods = 0.0;
+        _cycles = 0;
+    }
+
+private:
+    unsigned int    _sampleRate;    //!< Sampling rate in Hz.
+    T               _hysteresis;    //!< Arming level.
+    unsigned int    _holdoff;       //!< Minimum samples between crossings.
+    double          _index;         //!< Index of the next sample.
+    T               _previous;      //!< Previous sample.
+    bool            _armed;         //!< Below -hysteresis since the last crossing?
+    bool            _haveCrossing;  //!< Is _lastCrossing valid?
+    double          _lastCrossing;  //!< Interpolated index of the last crossing.
+    float           _frequency;     //!< Frequency of the last cycle.
+    double          _periods;       //!< Sum of periods in the window in samples.
+    unsigned int    _cycles;        //!< Cycles in the window.
+};
+
+} /* namespace PowerMonitor */
+
+#endif /* FREQUENCYESTIMATOR_H_ */
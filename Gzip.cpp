@@ -0,0 +1,45 @@
+/*
+ * Gzip.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <cstring>
+#include <stdexcept>
+#include "Gzip.h"
+
+namespace PowerMonitor
+{
+
+GzipEncoder::GzipEncoder(int level)
+{
+    if (level < 1 || level > 9)
+        throw std::invalid_argument("Gzip level must be from 1 to 9.");
+    memset(&_stream, 0, sizeof(_stream));
+    // 15 bits of window plus 16 selects the gzip format; 8 is zlib's
+    // default memory level.
+    if (deflateInit2(&_stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        throw std::runtime_error("Could not initialize zlib.");
+}
+
+GzipEncoder::~GzipEncoder()
+{
+    deflateEnd(&_stream);
+}
+
+const std::string& GzipEncoder::compress(const char* data, size_t size)
+{
+    deflateReset(&_stream);
+    // The bound holds even for incompressible data, one call does it all.
+    _output.resize(deflateBound(&_stream, size));
+    _stream.next_in = (Bytef*) data;
+    _stream.avail_in = size;
+    _stream.next_out = (Bytef*) &_output[0];
+    _stream.avail_out = _output.size();
+    if (deflate(&_stream, Z_FINISH) != Z_STREAM_END)
+        throw std::runtime_error("Could not compress batch.");
+    _output.resize(_stream.total_out);
+    return _output;
+}
+
+} /* namespace PowerMonitor */
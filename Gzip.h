@@ -0,0 +1,48 @@
+/*
+ * Gzip.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef GZIP_H_
+#define GZIP_H_
+
+#include <string>
+#include <zlib.h>
+
+namespace PowerMonitor
+{
+
+//! Gzip encoder for write batches.
+//!
+//! Every batch is a complete gzip stream, as the server decodes each
+//! request on its own. The deflate state and the output buffer are
+//! allocated once and reset for each batch, which saves zlib's setup of
+//! its window and hash tables, a large part of the cost of small batches.
+//!
+class GzipEncoder
+{
+public:
+    //! Constructor.
+    //! \param level compression level from 1 (fastest) to 9 (smallest).
+    explicit GzipEncoder(int level);
+    //! Destructor.
+    ~GzipEncoder();
+
+    //! Compresses a batch.
+    //! \param data batch to compress.
+    //! \param size length of the batch in bytes.
+    //! \return Gzip stream, valid until the next call.
+    const std::string& compress(const char* data, size_t size);
+
+private:
+    GzipEncoder(const GzipEncoder&);
+    GzipEncoder& operator=(const GzipEncoder&);
+
+    z_stream    _stream;    //!< Deflate state, reused.
+    std::string _output;    //!< Compressed batch, reused.
+};
+
+} /* namespace PowerMonitor */
+
+#endif /* GZIP_H_ */
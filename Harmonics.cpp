@@ -0,0 +1,55 @@
+/*
+ * Harmonics.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <cmath>
+#include <limits>
+#include "Harmonics.h"
+
+namespace PowerMonitor
+{
+
+Harmonics::Harmonics(unsigned int sampleRate, double fundamental, unsigned int maxHarmonic) :
+        _sampleRate(sampleRate),
+        _count(0),
+        _limit(std::numeric_limits<size_t>::max()),
+        _thd(0.f)
+{
+    for (unsigned int h = 1; h <= maxHarmonic && h * fundamental < sampleRate / 2.0; ++h)
+        _coefficients.push_back(2.0 * std::cos(6.283185307179586 * h * fundamental / sampleRate));
+    _s1.assign(_coefficients.size(), 0.0);
+    _s2.assign(_coefficients.size(), 0.0);
+    _magnitudes.assign(_coefficients.size(), 0.f);
+}
+
+void Harmonics::tune(double fundamental, size_t window)
+{
+    for (size_t k = 0; k < _coefficients.size(); ++k)
+        _coefficients[k] = 2.0 * std::cos(6.283185307179586 * (k + 1) * fundamental / _sampleRate);
+    const double cycle = _sampleRate / fundamental;
+    const double cycles = std::floor(window / cycle);
+    _limit = cycles > 0.0 ? (size_t) (cycles * cycle + 0.5) : window;
+}
+
+void Harmonics::finish(double scale)
+{
+    const size_t n = _coefficients.size();
+    double distortion = 0.0;
+    for (size_t k = 0; k < n; ++k)
+    {
+        double power = _s1[k] * _s1[k] + _s2[k] * _s2[k] - _coefficients[k] * _s1[k] * _s2[k];
+        // |X_k| / N is half the amplitude, the RMS value is sqrt(2) |X_k| / N.
+        double rms = _count ? scale * std::sqrt(2.0 * std::fabs(power)) / _count : 0.0;
+        _magnitudes[k] = rms;
+        if (k > 0)
+            distortion += rms * rms;
+        _s1[k] = 0.0;
+        _s2[k] = 0.0;
+    }
+    _thd = n && _magnitudes[0] > 0.f ? std::sqrt(distortion) / _magnitudes[0] : 0.f;
+    _count = 0;
+}
+
+} /* namespace PowerMonitor */
@@ -0,0 +1,106 @@
+/*
+ * Harmonics.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef HARMONICS_H_
+#define HARMONICS_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace PowerMonitor
+{
+
+//! Harmonic analysis with a bank of Goertzel filters.
+//!
+//! Tracks the 1st to nth harmonic of the mains frequency in a signal fed
+//! block by block. All state is allocated on construction. The analysis
+//! window ends with finish(); it should span a whole number of mains
+//! cycles, otherwise energy leaks between neighbouring harmonics. Since
+//! the mains frequency drifts, tune() follows the measured frequency and
+//! limits the analysis to the whole cycles that fit in the window.
+//! Harmonics at or above half the sampling rate are not tracked.
+//!
+class Harmonics
+{
+public:
+    //! Constructor.
+    //! \param sampleRate sampling rate in Hz.
+    //! \param fundamental mains frequency in Hz.
+    //! \param maxHarmonic highest harmonic to track.
+    Harmonics(unsigned int sampleRate, double fundamental, unsigned int maxHarmonic = 25);
+
+    //! Gets the number of tracked harmonics.
+    unsigned int harmonics() const
+    {
+        return _coefficients.size();
+    }
+
+    //! Retunes the filters to a measured fundamental frequency.
+    //!
+    //! Call between windows. Only the samples of the whole cycles at the
+    //! start of a window are analysed, the rest up to finish() is ignored.
+    //! The number of tracked harmonics stays as constructed.
+    //! \param fundamental mains frequency in Hz.
+    //! \param window samples per analysis window.
+    void tune(double fundamental, size_t window);
+
+    //! Feeds samples to the filters.
+    //! \param samples signal samples.
+    //! \param count number of samples.
+    template<class T> void process(const T* samples, size_t count)
+    {
+        if (count > _limit - _count)
+            count = _limit - _count;
+        const size_t n = _coefficients.size();
+        const double* c = _coefficients.data();
+        double* s1 = _s1.data();
+        double* s2 = _s2.data();
+        for (size_t i = 0; i < count; ++i)
+        {
+            const double x = samples[i];
+            // Independent recursions, one per harmonic.
+            for (size_t k = 0; k < n; ++k)
+            {
+                double s0 = x + c[k] * s1[k] - s2[k];
+                s2[k] = s1[k];
+                s1[k] = s0;
+            }
+        }
+        _count += count;
+    }
+
+    //! Ends the analysis window, updates the results and restarts.
+    //! \param scale factor from sample units to result units.
+    void finish(double scale = 1.0);
+
+    //! Gets the RMS value of a harmonic in the last window.
+    //! \param h harmonic number, 1 for the fundamental.
+    float magnitude(unsigned int h) const
+    {
+        return _magnitudes[h - 1];
+    }
+
+    //! Gets the total harmonic distortion of the last window.
+    //! \return RMS of harmonics 2..n relative to the fundamental.
+    float thd() const
+    {
+        return _thd;
+    }
+
+private:
+    std::vector<double> _coefficients;  //!< 2 cos(2 pi k f / fs) per harmonic.
+    std::vector<double> _s1;            //!< Previous filter state per harmonic.
+    std::vector<double> _s2;            //!< Second previous filter state per harmonic.
+    std::vector<float>  _magnitudes;    //!< Harmonic RMS values of the last window.
+    unsigned int        _sampleRate;    //!< Sampling rate in Hz.
+    size_t              _count;         //!< Samples in the current window.
+    size_t              _limit;         //!< Samples to analyse per window.
+    float               _thd;           //!< THD of the last window.
+};
+
+} /* namespace PowerMonitor */
+
+#endif /* HARMONICS_H_ */
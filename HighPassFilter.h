@@ -8,18 +8,59 @@
 #ifndef HIGHPASSFILTER_H_
 #define HIGHPASSFILTER_H_
 
+#include <cstdint>
+
 namespace PowerMonitor
 {
 
+//! Arithmetic of the high-pass filter for a sample type.
+//!
+//! Floating point samples use a coefficient of the same type. 32-bit
+//! integer samples use a Q30 fixed-point coefficient and a 64-bit product,
+//! so the filter runs without an FPU.
+//!
+template<class T> struct HighPassFilterTraits
+{
+    typedef T Coefficient;
+
+    static Coefficient coefficient(double alpha)
+    {
+        return alpha;
+    }
+    static T multiply(Coefficient alpha, T value)
+    {
+        return alpha * value;
+    }
+};
+
+template<> struct HighPassFilterTraits<int32_t>
+{
+    typedef int32_t Coefficient;
+    static const int fractionBits = 30;
+
+    static Coefficient coefficient(double alpha)
+    {
+        return (Coefficient) (alpha * (1 << fractionBits) + 0.5);
+    }
+    static int32_t multiply(Coefficient alpha, int32_t value)
+    {
+        return (int32_t) (((int64_t) alpha * value + (1 << (fractionBits - 1))) >> fractionBits);
+    }
+};
+
 //! Simple IIR high-pass filter.
 template<class T> class HighPassFilter
 {
 public:
+    typedef HighPassFilterTraits<T> Traits;
+
     //! Constructor.
     //! \param f crossover frequency in Hz.
     //! \param dt time step in s.
-    HighPassFilter(T dt, T f) :
-            _alpha(1.0 / (1.0 + 6.283185307 * f * dt)),
+    HighPassFilter(double dt, double f) :
+            _alpha(Traits::coefficient(1.0 / (1.0 + 6.283185307 * f * dt))),
+            _previousSample(),
+            _previousResult(),
             _initialized(false)
     {
     }
@@ -33,14 +74,14 @@ public:
             _initialized = true;
             return sample;
         }
-        T result = _alpha * (_previousResult + sample - _previousSample);
+        T result = Traits::multiply(_alpha, _previousResult + sample - _previousSample);
         _previousResult = result;
         _previousSample = sample;
         return result;
     }
 
 private:
-    T _alpha;               //!< Filter coefficient.
+    typename Traits::Coefficient _alpha;    //!< Filter coefficient.
     T _previousSample;      //!< Previous sample.
     T _previousResult;      //!< Previous filtered sample.
     bool _initialized;      //!< Previous samples initialized?
@@ -0,0 +1,116 @@
+/*
+ * Histogram.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace PowerMonitor
+{
+
+//! Lock-free log-linear histogram of durations.
+//!
+//! Values below 32 have a bucket each; above that every power of two is
+//! split into 16 buckets, as in HdrHistogram with one significant digit,
+//! so a recorded value is known within 6.25%. The buckets are a fixed
+//! array of atomic counters: recording never allocates or locks and may
+//! run on any thread while another thread drains the histogram.
+//!
+class Histogram
+{
+public:
+    //! Summary of the values recorded between two drains.
+    struct Summary
+    {
+        uint64_t count;     //!< Number of values.
+        uint64_t p50;       //!< Median, upper bound of its bucket.
+        uint64_t p99;       //!< 99th percentile, upper bound of its bucket.
+        uint64_t max;       //!< Largest value.
+    };
+
+    Histogram() :
+            _max(0)
+    {
+        for (unsigned int i = 0; i < BUCKETS; ++i)
+            _buckets[i].store(0, std::memory_order_relaxed);
+    }
+
+    //! Records a value.
+    void record(uint64_t value)
+    {
+        _buckets[_bucket(value)].fetch_add(1, std::memory_order_relaxed);
+        uint64_t max = _max.load(std::memory_order_relaxed);
+        while (value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    //! Summarizes and clears the recorded values.
+    Summary drain()
+    {
+        uint32_t counts[BUCKETS];
+        Summary summary = { 0, 0, 0, 0 };
+        for (unsigned int i = 0; i < BUCKETS; ++i)
+        {
+            // Only clear buckets in use, most of them stay empty.
+            counts[i] = _buckets[i].load(std::memory_order_relaxed);
+            if (counts[i] != 0)
+                counts[i] = _buckets[i].exchange(0, std::memory_order_relaxed);
+            summary.count += counts[i];
+        }
+        summary.max = _max.exchange(0, std::memory_order_relaxed);
+        if (summary.count == 0)
+            return summary;
+        uint64_t p50 = (summary.count + 1) / 2, p99 = summary.count - summary.count / 100;
+        uint64_t seen = 0;
+        for (unsigned int i = 0; i < BUCKETS; ++i)
+        {
+            if (counts[i] == 0)
+                continue;
+            if (seen < p50 && seen + counts[i] >= p50)
+                summary.p50 = _upper(i);
+            if (seen < p99 && seen + counts[i] >= p99)
+                summary.p99 = _upper(i);
+            seen += counts[i];
+        }
+        // A bucket bound may overshoot the exact maximum.
+        if (summary.p50 > summary.max)
+            summary.p50 = summary.max;
+        if (summary.p99 > summary.max)
+            summary.p99 = summary.max;
+        return summary;
+    }
+
+private:
+    static const unsigned int SUB_BITS = 4;
+    static const unsigned int SUB = 1 << SUB_BITS;
+    static const unsigned int BUCKETS = (65 - SUB_BITS) * SUB;
+
+    static unsigned int _bucket(uint64_t value)
+    {
+        if (value < 2 * SUB)
+            return value;
+        unsigned int shift = 63 - __builtin_clzll(value) - SUB_BITS;
+        return (shift + 1) * SUB + (unsigned int) (value >> shift) - SUB;
+    }
+    static uint64_t _upper(unsigned int bucket)
+    {
+        if (bucket < 2 * SUB)
+            return bucket;
+        unsigned int shift = bucket / SUB - 1;
+        uint64_t low = (uint64_t) (bucket % SUB + SUB) << shift;
+        return low + ((uint64_t) 1 << shift) - 1;
+    }
+
+    std::atomic<uint32_t> _buckets[BUCKETS];    //!< Number of values per bucket.
+    std::atomic<uint64_t> _max;                 //!< Largest value.
+};
+
+} /* namespace PowerMonitor */
+
+#endif /* HISTOGRAM_H_ */
@@ -1,66 +1,302 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 #include "InfluxdbWriter.h"
+#include "Metrics.h"
 
 namespace PowerMonitor
 {
 
-InfluxdbWriter::InfluxdbWriter(const std::string& host, const std::string& db, const std::string& user, const std::string& password) :
-        _running(0)
+InfluxdbWriter::InfluxdbWriter(const std::string& host, const std::string& db, const std::string& user, const std::string& password,
+        const Options& options) :
+        _options(options),
+        _first(0),
+        _count(0),
+        _inFlight(false),
+        _fromSpool(false),
+        _spooled(0),
+        _stop(false),
+        _dropped(0),
+        _failures(0)
 {
-    CURLcode ret;
-    struct curl_slist *list = NULL;
-    ret = curl_global_init(CURL_GLOBAL_ALL);
-    if (ret)
+    if (_options.queueSize == 0 || _options.batchSize == 0)
     {
-        throw std::runtime_error("Could not initialize curl: "
-                + std::string(curl_easy_strerror(ret)));
+        throw std::invalid_argument("InfluxDB queue and batch size must be positive.");
     }
-    _handle = curl_easy_init();
-    if (!_handle)
+    _transport = createTransport(host, db, user, password, _options.retentionPolicy, _options.datagramSize,
+            _options.gzipLevel, _options.gzipMinSize);
+
+    // Preallocate the queue so that steady state queueing reuses memory.
+    _lines.resize(_options.queueSize);
+    for (auto&& line : _lines)
+        line.reserve(128);
+    _enqueued.resize(_options.queueSize);
+    _payload.reserve(_options.batchSize * 128);
+    if (!_options.spoolPath.empty())
     {
-        curl_global_cleanup();
-        throw std::runtime_error("Unable to obtain curl handle.");
+        _spool.reset(new Spool(_options.spoolPath, _options.spoolSize));
+        _spooled = _spool->used();
     }
-    _multihandle = curl_multi_init();
-    if (!_multihandle)
+
+    _thread = std::thread(&InfluxdbWriter::_run, this);
+}
+
+InfluxdbWriter::~InfluxdbWriter()
+{
     {
-        curl_easy_cleanup(_handle);
-        curl_global_cleanup();
-        throw std::runtime_error("Unable to obtain curl multi handle.");
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
     }
+    _notEmpty.notify_one();
+    _notFull.notify_all();
+    _thread.join();
+}
 
-    std::stringstream url;
-    url << host << "/write?db=" << db;
-    curl_easy_setopt(_handle, CURLOPT_URL, url.str().c_str());
-    curl_easy_setopt(_handle, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
-    curl_easy_setopt(_handle, CURLOPT_USERNAME, user.c_str());
-    curl_easy_setopt(_handle, CURLOPT_PASSWORD, password.c_str());
-    list = curl_slist_append(list, "Expect:");
-    curl_easy_setopt(_handle, CURLOPT_HTTPHEADER, list);
+InfluxdbWriter::FullPolicy InfluxdbWriter::parsePolicy(const std::string& name)
+{
+    if (name == "dropoldest")
+        return DropOldest;
+    if (name == "dropnewest")
+        return DropNewest;
+    if (name == "block")
+        return Block;
+    throw std::invalid_argument("Unknown queue full policy: " + name);
 }
 
-InfluxdbWriter::~InfluxdbWriter()
+size_t InfluxdbWriter::spooled()
+{
+    return _spooled.load(std::memory_order_relaxed);
+}
+
+size_t InfluxdbWriter::queued()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _count;
+}
+
+void InfluxdbWriter::write(const LineProtocol& lines)
+{
+    write(lines.data(), lines.size());
+}
+
+void InfluxdbWriter::write(const char* data, size_t size)
 {
-    curl_multi_remove_handle(_multihandle, _handle);
-    curl_easy_cleanup(_handle);
-    curl_multi_cleanup(_multihandle);
-    curl_global_cleanup();
+    const char* p = data;
+    const char* end = p + size;
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (p < end)
+    {
+        const char* eol = (const char*) std::memchr(p, '\n', end - p);
+        if (eol == nullptr)
+            eol = end;
+        if (eol > p)
+            _enqueue(lock, p, eol - p);
+        p = eol + 1;
+    }
 }
 
-void InfluxdbWriter::_doSend()
+void InfluxdbWriter::_enqueue(std::unique_lock<std::mutex>& lock, const char* line, size_t length)
 {
-    curl_multi_perform(_multihandle, &_running);
-    if (!_running)
+    if (_count == _lines.size())
     {
-        std::stringstream payload;
-        for (auto&& line : _buffer)
+        switch (_options.fullPolicy)
+        {
+        case DropNewest:
+            _dropped++;
+            return;
+        case DropOldest:
+            _first = (_first + 1) % _lines.size();
+            _count--;
+            _dropped++;
+            break;
+        case Block:
+            _notFull.wait(lock, [this] { return _count < _lines.size() || _stop; });
+            if (_stop)
+            {
+                _dropped++;
+                return;
+            }
+            break;
+        }
+    }
+    size_t index = (_first + _count) % _lines.size();
+    _lines[index].assign(line, length);
+    _enqueued[index] = Clock::now();
+    _count++;
+    // The first line starts the batch age, a full batch goes right away.
+    if (_count == 1 || _count >= _options.batchSize)
+        _notEmpty.notify_one();
+}
+
+bool InfluxdbWriter::_takeBatch(bool flush, Clock::time_point deadline)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!flush)
+    {
+        // Wait until a batch is full or its oldest line is old enough.
+        while (!_stop && _count < _options.batchSize)
+        {
+            if (Clock::now() >= deadline)
+                return false;
+            if (_count == 0)
+            {
+                _notEmpty.wait_until(lock, deadline);
+                continue;
+            }
+            Clock::time_point aged = _enqueued[_first] + std::chrono::milliseconds(_options.batchAge);
+            if (Clock::now() >= aged)
+                break;
+            _notEmpty.wait_until(lock, std::min(aged, deadline));
+        }
+    }
+    if (_count == 0)
+        return false;
+
+    _payload.clear();
+    size_t n = std::min(_count, _options.batchSize);
+    for (size_t i = 0; i < n; ++i)
+    {
+        _payload += _lines[_first];
+        _payload += '\n';
+        _first = (_first + 1) % _lines.size();
+    }
+    _count -= n;
+    lock.unlock();
+    _notFull.notify_all();
+    return true;
+}
+
+void InfluxdbWriter::_spoolPayload()
+{
+    if (!_spool->append(_payload.data(), _payload.size()))
+        _dropped += std::count(_payload.begin(), _payload.end(), '\n');
+    _spooled = _spool->used();
+}
+
+void InfluxdbWriter::_start()
+{
+    _transport->start(_payload);
+    _inFlight = true;
+    _started = Clock::now();
+    _perform(0);
+}
+
+void InfluxdbWriter::_perform(int timeoutMs)
+{
+    Transport::Status status = _transport->poll(timeoutMs);
+    if (status == Transport::InFlight)
+        return;
+    bool ok = status == Transport::Sent;
+    if (Metrics::enabled)
+        Metrics::record(StageHttp, std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - _started).count());
+    _inFlight = false;
+    if (!ok)
+        _failures++;
+    if (!_spool)
+        return;
+    if (_fromSpool)
+    {
+        if (ok)
+            _spool->pop();
+        else
+            _nextReplay = Clock::now() + std::chrono::milliseconds(_options.retryInterval);
+        _spooled = _spool->used();
+    }
+    else if (!ok)
+    {
+        _spoolPayload();
+        _nextReplay = Clock::now() + std::chrono::milliseconds(_options.retryInterval);
+    }
+}
+
+void InfluxdbWriter::_abandon()
+{
+    if (_inFlight)
+    {
+        // A spooled write stays in the spool.
+        _inFlight = false;
+        _failures++;
+        if (!_fromSpool)
+        {
+            if (_spool)
+                _spoolPayload();
+            else
+                _dropped += std::count(_payload.begin(), _payload.end(), '\n');
+        }
+    }
+    if (_spool)
+    {
+        while (_takeBatch(true))
+            _spoolPayload();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _dropped += _count;
+    _count = 0;
+}
+
+void InfluxdbWriter::_run()
+{
+    Clock::time_point giveUp = Clock::time_point::max();
+    for (;;)
+    {
+        bool stopping;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            stopping = _stop;
+        }
+        if (stopping)
+        {
+            // Flush for at most the shutdown timeout.
+            Clock::time_point now = Clock::now();
+            if (giveUp == Clock::time_point::max())
+                giveUp = now + std::chrono::milliseconds(_options.shutdownTimeout);
+            if (now >= giveUp)
+            {
+                _abandon();
+                break;
+            }
+            if (_inFlight)
+            {
+                long long left = std::chrono::duration_cast<std::chrono::milliseconds>(giveUp - now).count();
+                _perform((int) std::min(100LL, left + 1));
+                continue;
+            }
+        }
+        else if (_inFlight)
+        {
+            _perform(100);
+            continue;
+        }
+        if (_spool && !_spool->empty())
+        {
+            // Keep the order: new batches queue up behind the spooled ones.
+            if (_takeBatch(stopping, stopping ? Clock::now() : _nextReplay))
+            {
+                _spoolPayload();
+                continue;
+            }
+            if (stopping)
+                break;
+            const char* data;
+            size_t size;
+            if (Clock::now() >= _nextReplay && _spool->front(data, size))
+            {
+                _payload.assign(data, size);
+                _fromSpool = true;
+                _nextReplay = Clock::now() + std::chrono::milliseconds(_options.replayInterval);
+                _start();
+            }
+            continue;
+        }
+        if (!_takeBatch(stopping))
         {
-            payload << line << "\n";
+            if (stopping)
+                break;
+            continue;
         }
-        _buffer.clear();
-        curl_multi_remove_handle(_multihandle, _handle);
-        curl_easy_setopt(_handle, CURLOPT_COPYPOSTFIELDS, payload.str().c_str());
-        curl_multi_add_handle(_multihandle, _handle);
-        curl_multi_perform(_multihandle, &_running);
+        _fromSpool = false;
+        _start();
     }
 }
 
@@ -1,13 +1,19 @@
 #ifndef INFLUXDBWRITER_H_
 #define INFLUXDBWRITER_H_
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <map>
-#include <deque>
-#include <sstream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <type_traits>
-#include <curl/curl.h>
+#include <vector>
+#include "LineProtocol.h"
+#include "Spool.h"
+#include "Transport.h"
 
 namespace PowerMonitor
 {
@@ -17,12 +23,71 @@ namespace PowerMonitor
 //! Sends measurements to InfluxDB. Supports integers, floats and strings,
 //! and string tags. Time stamps can be provided or generated on the fly.
 //!
+//! Lines are put in a bounded, preallocated queue and written by a
+//! background thread which drives the transport selected by the host URL,
+//! see createTransport(). A batch is sent
+//! when it reaches the batch size or when its oldest line reaches the
+//! batch age, independent of how often send() is called.
+//!
+//! With a spool configured, batches that fail to send are stored on disk
+//! and replayed in order at a throttled rate. While the spool holds
+//! batches, new batches are appended behind them to keep the order.
+//!
 class InfluxdbWriter
 {
 public:
+    //! What to do with a new line when the queue is full.
+    enum FullPolicy
+    {
+        DropOldest,     //!< Discard the oldest queued line.
+        DropNewest,     //!< Discard the new line.
+        Block           //!< Wait until the sender makes room.
+    };
+
+    //! Queueing and batching options.
+    struct Options
+    {
+        Options() :
+            queueSize(1024),
+            batchSize(100),
+            batchAge(1000),
+            fullPolicy(DropOldest),
+            spoolSize(16 * 1024 * 1024),
+            replayInterval(200),
+            retryInterval(10000),
+            shutdownTimeout(5000),
+            datagramSize(1400),
+            gzipLevel(0),
+            gzipMinSize(1024)
+        {
+        }
+        size_t queueSize;           //!< Maximum number of queued lines.
+        size_t batchSize;           //!< Maximum number of lines per write.
+        unsigned int batchAge;      //!< Maximum time a line waits for a batch in ms.
+        FullPolicy fullPolicy;      //!< Behaviour when the queue is full.
+        std::string spoolPath;      //!< Spool segment file, empty to disable spooling.
+        size_t spoolSize;           //!< Spool segment size in bytes.
+        unsigned int replayInterval;//!< Minimum time between spooled writes in ms.
+        unsigned int retryInterval; //!< Time to wait after a failed spooled write in ms.
+        unsigned int shutdownTimeout;//!< Maximum time to flush on destruction in ms.
+        std::string retentionPolicy;//!< Retention policy to write to, empty for the default.
+        size_t datagramSize;        //!< Maximum UDP payload in bytes.
+        int gzipLevel;              //!< HTTP compression level from 1 to 9, 0 for none.
+        size_t gzipMinSize;         //!< Smallest batch to compress in bytes.
+    };
+
     //! Constructor
-    InfluxdbWriter(const std::string& host, const std::string& db, const std::string& user, const std::string& password);
-    //! Destructor
+    //! \param host host URL, selects the transport.
+    //! \param db database.
+    //! \param user user name.
+    //! \param password password.
+    //! \param options queueing and batching options.
+    InfluxdbWriter(const std::string& host, const std::string& db, const std::string& user, const std::string& password,
+            const Options& options = Options());
+    //! Destructor, tries to send the remaining lines.
+    //!
+    //! Gives up after the shutdown timeout. The write in flight and the
+    //! lines still queued then go to the spool, or are counted as dropped.
     ~InfluxdbWriter();
     //! Send a measurement to InfluxDB.
     //! \param measurement measurement to send to.
@@ -33,22 +98,7 @@ public:
             const std::map<std::string, T>& values,
             long long timestamp = std::chrono::system_clock::now().time_since_epoch().count())
     {
-        std::stringstream ss;
-        ss << measurement << " ";
-        for (auto&& p : values)
-        {
-            if (!std::is_arithmetic<T>::value)
-                ss << p.first << "=\"" << p.second << "\",";
-            else if (std::is_integral<T>::value)
-                ss << p.first << "=" << p.second << "i,";
-            else
-                ss << p.first << "=" << p.second << ",";
-        }
-        // Replace the last comma with a whitespace.
-        ss.seekp(-1, ss.cur);
-        ss << " " << timestamp;
-        _buffer.push_back(ss.str());
-        _doSend();
+        send(measurement, values, std::map<std::string, std::string>(), timestamp);
     }
     //! Send a measurement to InfluxDB.
     //! \param measurement measurement to send to.
@@ -61,39 +111,89 @@ public:
             const std::map<std::string, std::string>& tags,
             long long timestamp = std::chrono::system_clock::now().time_since_epoch().count())
     {
-        std::stringstream ss;
-        ss << measurement << ",";
+        LineProtocol lines(256);
+        lines.begin(measurement.c_str());
         for (auto&& p : tags)
-        {
-            ss << p.first << "=" << p.second << ",";
-        }
-        // Replace the last comma with whitespace.
-        ss.seekp(-1, ss.cur);
-        ss << " ";
+            lines.tag(p.first.c_str(), p.second.c_str());
         for (auto&& p : values)
-        {
-            if (!std::is_arithmetic<T>::value)
-                ss << p.first << "=\"" << p.second << "\",";
-            else if (std::is_integral<T>::value)
-                ss << p.first << "=" << p.second << "i,";
-            else
-                ss << p.first << "=" << p.second << ",";
-        }
-        // Replace the last comma with whitespace.
-        ss.seekp(-1, ss.cur);
-        ss << " " << timestamp;
-        _buffer.push_back(ss.str());
-        _doSend();
+            _field(lines, p.first.c_str(), p.second);
+        lines.end(timestamp);
+        write(lines);
+    }
+    //! Send serialized lines to InfluxDB.
+    //!
+    //! Copies the lines into preallocated queue slots, so this does not
+    //! allocate once the slots have grown to the line length.
+    //! \param lines lines to send.
+    void write(const LineProtocol& lines);
+    //! Send serialized lines to InfluxDB.
+    //!
+    //! Takes the queue lock once for all lines, empty lines are skipped.
+    //! \param data lines separated by newlines.
+    //! \param size length of the lines in bytes.
+    void write(const char* data, size_t size);
+
+    //! Gets the number of queued lines.
+    size_t queued();
+    //! Gets the number of lines dropped because the queue was full.
+    unsigned long long dropped() const
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+    //! Gets the number of failed writes.
+    unsigned long long failures() const
+    {
+        return _failures.load(std::memory_order_relaxed);
     }
 
+    //! Gets the number of bytes waiting in the spool.
+    size_t spooled();
+
+    //! Parses a queue full policy name.
+    //! \param name "dropoldest", "dropnewest" or "block".
+    static FullPolicy parsePolicy(const std::string& name);
+
 private:
-    CURLM*                          _multihandle;
-    CURL*                           _handle;
-    std::deque<std::string>         _buffer;
-    int                             _running;
+    typedef std::chrono::steady_clock Clock;
 
-    void _doSend();
+    std::unique_ptr<Transport>      _transport;
+    Options                         _options;
+    std::vector<std::string>        _lines;         //!< Queue slots, reused.
+    std::vector<Clock::time_point>  _enqueued;      //!< Enqueue time of each slot.
+    size_t                          _first;         //!< Index of the oldest line.
+    size_t                          _count;         //!< Number of queued lines.
+    std::mutex                      _mutex;
+    std::condition_variable         _notEmpty;
+    std::condition_variable         _notFull;
+    std::string                     _payload;       //!< Body of the write in flight.
+    bool                            _inFlight;
+    Clock::time_point               _started;       //!< Start of the write in flight.
+    bool                            _fromSpool;     //!< Is the write in flight from the spool?
+    std::unique_ptr<Spool>          _spool;
+    std::atomic<size_t>             _spooled;       //!< Bytes in the spool.
+    Clock::time_point               _nextReplay;    //!< Earliest time for the next spooled write.
+    bool                            _stop;
+    std::atomic<unsigned long long> _dropped;
+    std::atomic<unsigned long long> _failures;
+    std::thread                     _thread;
 
+    template<class T> static typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type
+    _field(LineProtocol& lines, const char* key, const T& value)
+    {
+        lines.field(key, (long long) value);
+    }
+    template<class T> static typename std::enable_if<!std::is_integral<T>::value || std::is_same<T, bool>::value>::type
+    _field(LineProtocol& lines, const char* key, const T& value)
+    {
+        lines.field(key, value);
+    }
+    void _enqueue(std::unique_lock<std::mutex>& lock, const char* line, size_t length);
+    void _run();
+    bool _takeBatch(bool flush, Clock::time_point deadline = Clock::time_point::max());
+    void _start();
+    void _perform(int timeoutMs);
+    void _spoolPayload();
+    void _abandon();
 };
 
 }
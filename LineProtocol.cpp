@@ -0,0 +1,375 @@
+/*
+ * LineProtocol.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "LineProtocol.h"
+
+namespace PowerMonitor
+{
+
+namespace
+{
+
+const char digitPairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+const double powers[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+//! Writes the decimal digits of value, returns the number of digits.
+size_t formatUnsigned(unsigned long long value, char* out)
+{
+    char tmp[20];
+    char* p = tmp + sizeof(tmp);
+    while (value >= 100)
+    {
+        unsigned int i = (value % 100) * 2;
+        value /= 100;
+        *--p = digitPairs[i + 1];
+        *--p = digitPairs[i];
+    }
+    if (value >= 10)
+    {
+        unsigned int i = value * 2;
+        *--p = digitPairs[i + 1];
+        *--p = digitPairs[i];
+    }
+    else
+        *--p = '0' + value;
+    size_t n = tmp + sizeof(tmp) - p;
+    std::memcpy(out, p, n);
+    return n;
+}
+
+//! Scales v by 10^k, exactly for |k| <= 22.
+inline double scale10(double v, int k)
+{
+    return k >= 0 ? v * powers[k] : v / powers[-k];
+}
+
+//! Checks that the decimal m * 10^k reads back as the float |value|.
+//!
+//! m has at most 9 digits and converts exactly, so scale10() rounds once.
+//! Rounding is monotonic: a result strictly between the midpoints to the
+//! neighbouring floats means the decimal itself is, and reads back as
+//! value. A result on a midpoint may be either, so it is rejected.
+inline bool roundTrips(float value, unsigned long long m, int k)
+{
+    float v = std::fabs(value);
+    // The neighbours of a positive float are one step away in its bits.
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    uint32_t neighbours[2] = { bits - 1, bits + 1 };
+    float next[2];
+    std::memcpy(next, neighbours, sizeof(next));
+    double back = scale10((double) m, k);
+    return back > ((double) v + next[0]) / 2 && back < ((double) v + next[1]) / 2;
+}
+
+//! Checks that the decimal m * 10^k reads back as the double |value|.
+//!
+//! Up to 2^53, m converts exactly and scale10() rounds once, like strtod().
+//! A larger m would round twice, which can mistake a neighbour for value.
+inline bool roundTrips(double value, unsigned long long m, int k)
+{
+    if (m > (1ULL << 53))
+        return false;
+    return scale10((double) m, k) == std::fabs(value);
+}
+
+//! Formats |value| with digits significant digits if that reads back the same.
+//! \return Number of characters written or 0 if the result does not round trip.
+template<class T> size_t formatDigits(T value, int digits, int exponent, char* out)
+{
+    double v = std::fabs((double) value);
+    unsigned long long m = (unsigned long long) std::llround(scale10(v, digits - 1 - exponent));
+    if (m < (unsigned long long) powers[digits - 1])
+    {
+        // Exponent estimate was one too high.
+        exponent--;
+        m = (unsigned long long) std::llround(scale10(v, digits - 1 - exponent));
+    }
+    if (m >= (unsigned long long) powers[digits])
+    {
+        // Rounded up to the next power of ten.
+        m /= 10;
+        exponent++;
+    }
+    if (!roundTrips(value, m, exponent - (digits - 1)))
+        return 0;
+
+    // Drop trailing zeros.
+    while (digits > 1 && m % 10 == 0)
+    {
+        m /= 10;
+        digits--;
+    }
+    char mantissa[20];
+    formatUnsigned(m, mantissa);
+
+    char* p = out;
+    if (exponent < 0)
+    {
+        *p++ = '0';
+        *p++ = '.';
+        for (int i = -1; i > exponent; --i)
+            *p++ = '0';
+        std::memcpy(p, mantissa, digits);
+        p += digits;
+    }
+    else if (exponent + 1 >= digits)
+    {
+        std::memcpy(p, mantissa, digits);
+        p += digits;
+        for (int i = digits; i <= exponent; ++i)
+            *p++ = '0';
+    }
+    else
+    {
+        std::memcpy(p, mantissa, exponent + 1);
+        p += exponent + 1;
+        *p++ = '.';
+        std::memcpy(p, mantissa + exponent + 1, digits - exponent - 1);
+        p += digits - exponent - 1;
+    }
+    return p - out;
+}
+
+//! Shortest round trip formatting between minDigits and maxDigits digits.
+template<class T> size_t formatShortest(T value, int minDigits, int maxDigits, const char* fallback, char* out)
+{
+    char* p = out;
+    if (value == 0)
+    {
+        *p = '0';
+        return 1;
+    }
+    double v = std::fabs((double) value);
+    // Numbers outside this range are rare, use the C library for them.
+    if (v < 1e-6 || v >= 1e15)
+        return std::snprintf(out, 32, fallback, (double) value);
+    if (value < 0)
+        *p++ = '-';
+    // Decimal exponent of the leading digit.
+    int exponent = 0;
+    if (v >= 1.0)
+    {
+        while (exponent < 15 && v >= powers[exponent + 1])
+            exponent++;
+    }
+    else
+    {
+        do
+            exponent--;
+        while (v < scale10(1.0, exponent));
+    }
+    for (int digits = minDigits; digits <= maxDigits; ++digits)
+    {
+        size_t n = formatDigits(value, digits, exponent, p);
+        if (n > 0)
+            return p - out + n;
+    }
+    // The C library rounds correctly, the fallback always reads back.
+    return std::snprintf(out, 32, fallback, (double) value);
+}
+
+}
+
+LineProtocol::Prefix::Prefix(const std::string& measurement, const std::map<std::string, std::string>& tags)
+{
+    LineProtocol lp(measurement.size() + 64);
+    lp.begin(measurement.c_str());
+    for (auto&& p : tags)
+        lp.tag(p.first.c_str(), p.second.c_str());
+    _text.assign(lp.data(), lp.size());
+}
+
+LineProtocol::LineProtocol(size_t capacity) :
+        _buffer(capacity > 64 ? capacity : 64),
+        _size(0),
+        _lineStart(0),
+        _fields(0)
+{
+}
+
+char* LineProtocol::_reserve(size_t n)
+{
+    if (_size + n > _buffer.size())
+    {
+        size_t capacity = _buffer.size() * 2;
+        while (capacity < _size + n)
+            capacity *= 2;
+        _buffer.resize(capacity);
+    }
+    return &_buffer[_size];
+}
+
+void LineProtocol::_append(const char* s, size_t n)
+{
+    std::memcpy(_reserve(n), s, n);
+    _size += n;
+}
+
+void LineProtocol::_appendEscaped(const char* s, Escape escape)
+{
+    for (; *s; ++s)
+    {
+        char c = *s;
+        bool special;
+        switch (escape)
+        {
+        case Measurement:
+            special = c == ',' || c == ' ';
+            break;
+        case Key:
+            special = c == ',' || c == '=' || c == ' ';
+            break;
+        default:
+            special = c == '"' || c == '\\';
+            break;
+        }
+        char* p = _reserve(2);
+        if (special)
+        {
+            *p++ = '\\';
+            _size++;
+        }
+        *p = c;
+        _size++;
+    }
+}
+
+LineProtocol& LineProtocol::begin(const Prefix& prefix)
+{
+    _lineStart = _size;
+    _fields = 0;
+    _append(prefix.str().data(), prefix.str().size());
+    return *this;
+}
+
+LineProtocol& LineProtocol::begin(const char* measurement)
+{
+    _lineStart = _size;
+    _fields = 0;
+    _appendEscaped(measurement, Measurement);
+    return *this;
+}
+
+LineProtocol& LineProtocol::tag(const char* key, const char* value)
+{
+    _append(",", 1);
+    _appendEscaped(key, Key);
+    _append("=", 1);
+    _appendEscaped(value, Key);
+    return *this;
+}
+
+void LineProtocol::_fieldKey(const char* key)
+{
+    _append(_fields++ ? "," : " ", 1);
+    _appendEscaped(key, Key);
+    _append("=", 1);
+}
+
+LineProtocol& LineProtocol::field(const char* key, float value)
+{
+    if (!std::isfinite(value))
+        return *this;
+    _fieldKey(key);
+    _size += formatFloat(value, _reserve(32));
+    return *this;
+}
+
+LineProtocol& LineProtocol::field(const char* key, double value)
+{
+    if (!std::isfinite(value))
+        return *this;
+    _fieldKey(key);
+    _size += formatDouble(value, _reserve(32));
+    return *this;
+}
+
+LineProtocol& LineProtocol::field(const char* key, long long value)
+{
+    _fieldKey(key);
+    char* p = _reserve(22);
+    size_t n = formatInteger(value, p);
+    p[n] = 'i';
+    _size += n + 1;
+    return *this;
+}
+
+LineProtocol& LineProtocol::field(const char* key, bool value)
+{
+    _fieldKey(key);
+    if (value)
+        _append("true", 4);
+    else
+        _append("false", 5);
+    return *this;
+}
+
+LineProtocol& LineProtocol::field(const char* key, const char* value)
+{
+    _fieldKey(key);
+    _append("\"", 1);
+    _appendEscaped(value, String);
+    _append("\"", 1);
+    return *this;
+}
+
+void LineProtocol::end(long long timestamp)
+{
+    if (_fields == 0)
+    {
+        // A point needs at least one field.
+        _size = _lineStart;
+        return;
+    }
+    char* p = _reserve(23);
+    *p = ' ';
+    size_t n = formatInteger(timestamp, p + 1);
+    p[n + 1] = '\n';
+    _size += n + 2;
+    _lineStart = _size;
+    _fields = 0;
+}
+
+size_t LineProtocol::formatFloat(float value, char* out)
+{
+    return formatShortest(value, 6, 9, "%.9g", out);
+}
+
+size_t LineProtocol::formatDouble(double value, char* out)
+{
+    return formatShortest(value, 15, 17, "%.17g", out);
+}
+
+size_t LineProtocol::formatInteger(long long value, char* out)
+{
+    if (value < 0)
+    {
+        *out = '-';
+        return 1 + formatUnsigned(0ULL - (unsigned long long) value, out + 1);
+    }
+    return formatUnsigned(value, out);
+}
+
+} /* namespace PowerMonitor */
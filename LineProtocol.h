@@ -0,0 +1,148 @@
+/*
+ * LineProtocol.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef LINEPROTOCOL_H_
+#define LINEPROTOCOL_H_
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace PowerMonitor
+{
+
+//! InfluxDB line protocol serializer.
+//!
+//! Appends points directly to a reusable byte buffer which only grows,
+//! so serializing a point does not allocate once the buffer has reached
+//! its working size. Numbers are formatted without the C++ streams: floats
+//! with the shortest representation that reads back to the same float,
+//! integers with a digit pair table. Non-finite values are not valid in
+//! line protocol and are skipped; a point without any fields is dropped.
+//!
+//! \code
+//! LineProtocol::Prefix power("power", {{ "host", "galileo" }});
+//! LineProtocol lines;
+//! lines.begin(power).field("l1", p1).field("pf1", pf1).end(timestamp);
+//! \endcode
+//!
+class LineProtocol
+{
+public:
+    //! Precomputed, escaped measurement name and tags of a fixed schema.
+    class Prefix
+    {
+    public:
+        //! Constructor.
+        //! \param measurement measurement name.
+        //! \param tags map of key-value-pairs.
+        Prefix(const std::string& measurement,
+                const std::map<std::string, std::string>& tags = std::map<std::string, std::string>());
+        //! Gets the escaped prefix.
+        const std::string& str() const
+        {
+            return _text;
+        }
+    private:
+        std::string _text;
+    };
+
+    //! Constructor.
+    //! \param capacity initial buffer size in bytes.
+    explicit LineProtocol(size_t capacity = 1024);
+
+    //! Starts a new point with a precomputed prefix.
+    LineProtocol& begin(const Prefix& prefix);
+    //! Starts a new point.
+    //! \param measurement measurement name, escaped as needed.
+    LineProtocol& begin(const char* measurement);
+    //! Adds a tag, must come before the fields.
+    LineProtocol& tag(const char* key, const char* value);
+    //! Adds a float field.
+    LineProtocol& field(const char* key, float value);
+    //! Adds a double field.
+    LineProtocol& field(const char* key, double value);
+    //! Adds an integer field.
+    LineProtocol& field(const char* key, long long value);
+    //! Adds an integer field.
+    LineProtocol& field(const char* key, int value)
+    {
+        return field(key, (long long) value);
+    }
+    //! Adds a boolean field.
+    LineProtocol& field(const char* key, bool value);
+    //! Adds a string field.
+    LineProtocol& field(const char* key, const char* value);
+    //! Adds a string field.
+    LineProtocol& field(const char* key, const std::string& value)
+    {
+        return field(key, value.c_str());
+    }
+    //! Ends the current point.
+    //! \param timestamp timestamp in nanoseconds since Unix epoch.
+    void end(long long timestamp);
+
+    //! Gets the serialized lines, each terminated by a newline.
+    const char* data() const
+    {
+        return _buffer.data();
+    }
+    //! Gets the length of the serialized lines in bytes.
+    size_t size() const
+    {
+        return _size;
+    }
+    //! Removes all lines, keeping the buffer.
+    void clear()
+    {
+        _size = 0;
+        _lineStart = 0;
+        _fields = 0;
+    }
+
+    //! Formats a float with the shortest round trip representation.
+    //! \param value value to format, must be finite.
+    //! \param out buffer of at least 32 bytes.
+    //! \return Number of characters written.
+    static size_t formatFloat(float value, char* out);
+    //! Formats a double with the shortest round trip representation.
+    //!
+    //! Mantissas above 2^53 cannot be checked exactly in double arithmetic,
+    //! such values get 17 digits from the C library instead, which may be
+    //! one more than needed.
+    //! \param value value to format, must be finite.
+    //! \param out buffer of at least 32 bytes.
+    //! \return Number of characters written.
+    static size_t formatDouble(double value, char* out);
+    //! Formats an integer.
+    //! \param value value to format.
+    //! \param out buffer of at least 21 bytes.
+    //! \return Number of characters written.
+    static size_t formatInteger(long long value, char* out);
+
+private:
+    enum Escape
+    {
+        Measurement,    //!< Escape commas and spaces.
+        Key,            //!< Escape commas, equal signs and spaces.
+        String          //!< Escape double quotes and backslashes.
+    };
+
+    char* _reserve(size_t n);
+    void _append(const char* s, size_t n);
+    void _appendEscaped(const char* s, Escape escape);
+    void _fieldKey(const char* key);
+
+    std::vector<char>   _buffer;        //!< Serialized data, grows as needed.
+    size_t              _size;          //!< Bytes used in the buffer.
+    size_t              _lineStart;     //!< Start of the current point.
+    unsigned int        _fields;        //!< Fields in the current point.
+};
+
+} /* namespace PowerMonitor */
+
+#endif /* LINEPROTOCOL_H_ */
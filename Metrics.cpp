@@ -0,0 +1,52 @@
+/*
+ * Metrics.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+#include <time.h>
+#include "LineProtocol.h"
+#include "Metrics.h"
+
+namespace PowerMonitor
+{
+
+Histogram Metrics::_histograms[StageCount];
+
+uint64_t Metrics::now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void Metrics::write(LineProtocol& lines, long long timestamp)
+{
+    static const char* names[StageCount] = {
+        "refill", "read", "convert", "process", "harmonics", "serialize",
+        "enqueue", "http"
+    };
+    static std::vector<LineProtocol::Prefix> points;
+    if (points.empty())
+    {
+        for (unsigned int s = 0; s < StageCount; ++s)
+            points.emplace_back("powermon_internal", std::map<std::string, std::string>{ { "stage", names[s] } });
+    }
+    for (unsigned int s = 0; s < StageCount; ++s)
+    {
+        Histogram::Summary summary = _histograms[s].drain();
+        if (summary.count == 0)
+            continue;
+        lines.begin(points[s])
+                .field("p50", (long long) summary.p50)
+                .field("p99", (long long) summary.p99)
+                .field("max", (long long) summary.max)
+                .field("count", (long long) summary.count)
+                .end(timestamp);
+    }
+}
+
+} /* namespace PowerMonitor */
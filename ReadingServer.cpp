@@ -0,0 +1,319 @@
+/*
+ * ReadingServer.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "ReadingServer.h"
+
+namespace PowerMonitor
+{
+
+// Limits that keep a misbehaving client from using up the server.
+static const size_t MAX_CLIENTS = 16;
+static const size_t MAX_REQUEST = 1024;
+
+static void setNonBlocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+static void appendFloat(std::string& out, float value)
+{
+    if (!std::isfinite(value))
+    {
+        out += "null";
+        return;
+    }
+    char buffer[32];
+    out.append(buffer, LineProtocol::formatFloat(value, buffer));
+}
+
+static void appendString(std::string& out, const std::string& value)
+{
+    out += '"';
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        if ((unsigned char) c >= 0x20)
+            out += c;
+    }
+    out += '"';
+}
+
+ReadingServer::ReadingServer(const std::vector<std::string>& names, const std::string& socketPath,
+        const std::string& address, unsigned int port) :
+        _names(names),
+        _socketPath(socketPath),
+        _unix(-1),
+        _tcp(-1)
+{
+    if (names.size() > Reading::MAX_CIRCUITS)
+        throw std::runtime_error("Too many circuits for the readings server.");
+    for (unsigned int i = 1; i <= names.size(); ++i)
+        _pfNames.push_back("pf" + std::to_string(i));
+    if (pipe(_wake) < 0)
+        throw std::runtime_error("Could not create pipe: " + std::string(strerror(errno)));
+    setNonBlocking(_wake[0]);
+    setNonBlocking(_wake[1]);
+    try
+    {
+        if (!socketPath.empty())
+        {
+            struct sockaddr_un addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            if (socketPath.size() >= sizeof(addr.sun_path))
+                throw std::runtime_error("Socket path too long: " + socketPath);
+            strcpy(addr.sun_path, socketPath.c_str());
+            unlink(socketPath.c_str());
+            _unix = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (_unix < 0 || bind(_unix, (struct sockaddr*) &addr, sizeof(addr)) < 0 || listen(_unix, 8) < 0)
+                throw std::runtime_error("Could not listen on " + socketPath + ": " + std::string(strerror(errno)));
+            setNonBlocking(_unix);
+        }
+        if (port != 0)
+        {
+            struct sockaddr_in addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1)
+                throw std::runtime_error("Invalid listen address: " + address);
+            _tcp = socket(AF_INET, SOCK_STREAM, 0);
+            int on = 1;
+            if (_tcp >= 0)
+                setsockopt(_tcp, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            if (_tcp < 0 || bind(_tcp, (struct sockaddr*) &addr, sizeof(addr)) < 0 || listen(_tcp, 8) < 0)
+                throw std::runtime_error("Could not listen on port " + std::to_string(port) + ": "
+                        + std::string(strerror(errno)));
+            setNonBlocking(_tcp);
+        }
+    }
+    catch (...)
+    {
+        _close();
+        throw;
+    }
+    _thread = std::thread(&ReadingServer::_run, this);
+}
+
+ReadingServer::~ReadingServer()
+{
+    char c = 0;
+    if (write(_wake[1], &c, 1) < 0)
+    {
+        // The pipe is never full, nothing to do.
+    }
+    _thread.join();
+    _close();
+}
+
+void ReadingServer::publish(const BlockResult& result)
+{
+    Reading reading;
+    reading.timestamp = result.timestamp;
+    reading.vRMS = result.vRMS;
+    reading.frequency = result.frequency;
+    reading.circuits = std::min<size_t>(result.power.size(), _names.size());
+    for (unsigned int i = 0; i < reading.circuits; ++i)
+    {
+        reading.iRMS[i] = result.iRMS[i];
+        reading.power[i] = result.power[i];
+        reading.powerFactor[i] = result.powerFactor[i];
+    }
+    _reading.write(reading);
+}
+
+void ReadingServer::_run()
+{
+    std::vector<struct pollfd> fds;
+    for (;;)
+    {
+        fds.clear();
+        fds.push_back(pollfd { _wake[0], POLLIN, 0 });
+        if (_unix >= 0)
+            fds.push_back(pollfd { _unix, POLLIN, 0 });
+        if (_tcp >= 0)
+            fds.push_back(pollfd { _tcp, POLLIN, 0 });
+        const size_t listeners = fds.size();
+        for (auto&& client : _clients)
+            fds.push_back(pollfd { client.fd, POLLIN, 0 });
+        if (poll(fds.data(), fds.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        if (fds[0].revents)
+            return;
+        for (size_t i = 1; i < listeners; ++i)
+        {
+            if (!(fds[i].revents & POLLIN))
+                continue;
+            int fd = accept(fds[i].fd, nullptr, nullptr);
+            if (fd < 0)
+                continue;
+            if (_clients.size() >= MAX_CLIENTS)
+            {
+                close(fd);
+                continue;
+            }
+            setNonBlocking(fd);
+            _clients.push_back(Client { fd, std::string() });
+        }
+        // Clients accepted above were not polled yet and come last.
+        size_t polled = fds.size() - listeners;
+        for (size_t i = polled; i-- > 0;)
+        {
+            if (fds[listeners + i].revents == 0)
+                continue;
+            if (!_handle(_clients[i]))
+            {
+                close(_clients[i].fd);
+                _clients.erase(_clients.begin() + i);
+            }
+        }
+    }
+}
+
+bool ReadingServer::_handle(Client& client)
+{
+    char buffer[512];
+    ssize_t n = recv(client.fd, buffer, sizeof(buffer), 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR))
+        return false;
+    if (n > 0)
+        client.input.append(buffer, n);
+    size_t end;
+    while ((end = client.input.find('\n')) != std::string::npos)
+    {
+        std::string request = client.input.substr(0, end);
+        client.input.erase(0, end + 1);
+        if (!request.empty() && request[request.size() - 1] == '\r')
+            request.erase(request.size() - 1);
+        if (!_respond(client, request))
+            return false;
+    }
+    return client.input.size() <= MAX_REQUEST;
+}
+
+bool ReadingServer::_respond(Client& client, const std::string& request)
+{
+    Reading reading;
+    _reading.read(reading);
+    std::string body;
+    bool http = request.compare(0, 4, "GET ") == 0;
+    std::string what = request;
+    if (http)
+    {
+        size_t end = request.find(' ', 4);
+        what = request.substr(4, end == std::string::npos ? std::string::npos : end - 4);
+        if (what == "/" || what == "/json")
+            what = "json";
+        else if (what == "/line")
+            what = "line";
+    }
+    const char* type = "application/json";
+    int status = 200;
+    if (what == "json" || what.empty())
+        _json(reading, body);
+    else if (what == "line")
+    {
+        _lines(reading, body);
+        type = "text/plain";
+    }
+    else
+    {
+        body = "{\"error\":\"unknown request\"}\n";
+        status = 404;
+    }
+
+    std::string response;
+    if (http)
+    {
+        response = "HTTP/1.0 " + std::string(status == 200 ? "200 OK" : "404 Not Found")
+                + "\r\nContent-Type: " + type
+                + "\r\nContent-Length: " + std::to_string(body.size())
+                + "\r\nConnection: close\r\n\r\n";
+    }
+    response += body;
+    // Responses are small; a client that does not take one at once is dropped.
+    ssize_t sent = send(client.fd, response.data(), response.size(), MSG_NOSIGNAL);
+    return sent == (ssize_t) response.size() && !http;
+}
+
+void ReadingServer::_json(const Reading& reading, std::string& out)
+{
+    out += "{\"timestamp\":";
+    out += std::to_string(reading.timestamp);
+    out += ",\"voltage\":";
+    appendFloat(out, reading.vRMS);
+    out += ",\"frequency\":";
+    appendFloat(out, reading.frequency);
+    out += ",\"circuits\":[";
+    for (unsigned int i = 0; i < reading.circuits; ++i)
+    {
+        out += i == 0 ? "{\"name\":" : ",{\"name\":";
+        appendString(out, _names[i]);
+        out += ",\"current\":";
+        appendFloat(out, reading.iRMS[i]);
+        out += ",\"power\":";
+        appendFloat(out, reading.power[i]);
+        out += ",\"pf\":";
+        appendFloat(out, reading.powerFactor[i]);
+        out += '}';
+    }
+    out += "]}\n";
+}
+
+void ReadingServer::_lines(const Reading& reading, std::string& out)
+{
+    _protocol.clear();
+    if (reading.timestamp != 0)
+    {
+        _protocol.begin("voltage")
+                .field("voltage", reading.vRMS)
+                .field("frequency", reading.frequency)
+                .end(reading.timestamp);
+        _protocol.begin("power");
+        for (unsigned int i = 0; i < reading.circuits; ++i)
+            _protocol.field(_names[i].c_str(), reading.power[i]);
+        for (unsigned int i = 0; i < reading.circuits; ++i)
+            _protocol.field(_pfNames[i].c_str(), reading.powerFactor[i]);
+        _protocol.end(reading.timestamp);
+    }
+    out.append(_protocol.data(), _protocol.size());
+}
+
+void ReadingServer::_close()
+{
+    for (auto&& client : _clients)
+        close(client.fd);
+    _clients.clear();
+    if (_unix >= 0)
+    {
+        close(_unix);
+        unlink(_socketPath.c_str());
+    }
+    if (_tcp >= 0)
+        close(_tcp);
+    close(_wake[0]);
+    close(_wake[1]);
+}
+
+} /* namespace PowerMonitor */
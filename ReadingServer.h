@@ -0,0 +1,95 @@
+/*
+ * ReadingServer.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef READINGSERVER_H_
+#define READINGSERVER_H_
+
+#include <string>
+#include <thread>
+#include <vector>
+#include "BlockProcessor.h"
+#include "LineProtocol.h"
+#include "Seqlock.h"
+
+namespace PowerMonitor
+{
+
+//! Latest results of all circuits.
+struct Reading
+{
+    static const unsigned int MAX_CIRCUITS = 16;
+
+    long long timestamp;                    //!< Time of the results in nanoseconds since Unix epoch, 0 before the first.
+    float vRMS;                             //!< Voltage RMS in volts.
+    float frequency;                        //!< Mains frequency in Hz.
+    unsigned int circuits;                  //!< Number of circuits.
+    float iRMS[MAX_CIRCUITS];               //!< Circuit current RMS in amperes.
+    float power[MAX_CIRCUITS];              //!< Circuit real power in watts.
+    float powerFactor[MAX_CIRCUITS];        //!< Circuit power factor.
+};
+
+//! Serves the latest results to local clients.
+//!
+//! The measurement thread publishes each result into a Seqlock, which never
+//! blocks it. A server thread accepts connections on a Unix socket and/or
+//! a TCP port and answers from the snapshot:
+//!
+//! - A line "json" or an empty line returns the results as a JSON object,
+//!   "line" returns them as InfluxDB line protocol. The connection stays
+//!   open for further requests.
+//! - "GET /json" or "GET /line" answers as an HTTP/1.0 server and closes,
+//!   e.g. curl --unix-socket /run/powermon.sock http://localhost/json.
+//!
+class ReadingServer
+{
+public:
+    //! Constructor, opens the sockets and starts the server thread.
+    //! \param names circuit names in result order.
+    //! \param socketPath Unix socket path, empty for none.
+    //! \param address TCP address to listen on.
+    //! \param port TCP port, 0 for none.
+    ReadingServer(const std::vector<std::string>& names, const std::string& socketPath,
+            const std::string& address, unsigned int port);
+    //! Destructor, stops the server thread and closes the sockets.
+    ~ReadingServer();
+
+    //! Publishes new results, never blocks.
+    //! \param result results of a reporting window.
+    void publish(const BlockResult& result);
+
+private:
+    //! Connected client.
+    struct Client
+    {
+        int fd;                 //!< Socket.
+        std::string input;      //!< Received data not yet handled.
+    };
+
+    ReadingServer(const ReadingServer&);
+    ReadingServer& operator=(const ReadingServer&);
+
+    void _run();
+    bool _handle(Client& client);
+    bool _respond(Client& client, const std::string& request);
+    void _json(const Reading& reading, std::string& out);
+    void _lines(const Reading& reading, std::string& out);
+    void _close();
+
+    std::vector<std::string>    _names;         //!< Circuit names.
+    std::vector<std::string>    _pfNames;       //!< Power factor field names.
+    Seqlock<Reading>            _reading;       //!< Latest results.
+    std::string                 _socketPath;    //!< Unix socket path.
+    int                         _unix;          //!< Unix listening socket or -1.
+    int                         _tcp;           //!< TCP listening socket or -1.
+    int                         _wake[2];       //!< Pipe to stop the server thread.
+    std::vector<Client>         _clients;       //!< Connected clients.
+    LineProtocol                _protocol;      //!< Line protocol buffer.
+    std::thread                 _thread;        //!< Server thread.
+};
+
+} /* namespace PowerMonitor */
+
+#endif /* READINGSERVER_H_ */
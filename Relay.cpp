@@ -0,0 +1,479 @@
+/*
+ * Relay.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "Configuration.h"
+#include "Relay.h"
+#include "Transport.h"
+
+namespace PowerMonitor
+{
+
+// Datagrams received with one recvmmsg() call, and the largest datagram.
+static const unsigned int DATAGRAMS = 16;
+static const size_t MAX_DATAGRAM = 65536;
+// Limit that keeps connection floods from using up a worker.
+static const size_t MAX_CONNECTIONS = 1024;
+
+//! Opens a socket bound to an address, listening for streams.
+//! \param address address to bind to.
+//! \param port port.
+//! \param type SOCK_DGRAM or SOCK_STREAM.
+//! \return Non-blocking socket.
+static int bindSocket(const std::string& address, unsigned int port, int type)
+{
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = type;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST;
+    struct addrinfo* addresses;
+    if (getaddrinfo(address.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0)
+        throw std::runtime_error("Invalid listen address: " + address);
+    int s = socket(addresses->ai_family, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int on = 1;
+    if (s >= 0)
+    {
+        setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        // Every worker binds its own socket to the port.
+        setsockopt(s, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    }
+    if (s < 0 || bind(s, addresses->ai_addr, addresses->ai_addrlen) < 0
+            || (type == SOCK_STREAM && listen(s, 128) < 0))
+    {
+        std::string error = strerror(errno);
+        freeaddrinfo(addresses);
+        if (s >= 0)
+            close(s);
+        throw std::runtime_error("Could not listen on " + std::string(type == SOCK_STREAM ? "TCP" : "UDP")
+                + " port " + std::to_string(port) + ": " + error);
+    }
+    freeaddrinfo(addresses);
+    if (type == SOCK_DGRAM)
+    {
+        // Room for bursts while the worker is busy.
+        int size = 4 * 1024 * 1024;
+        setsockopt(s, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+    return s;
+}
+
+//! Gets the address of a peer without its port.
+static std::string peerAddress(const struct sockaddr_storage& address)
+{
+    char text[INET6_ADDRSTRLEN];
+    if (address.ss_family == AF_INET)
+        inet_ntop(AF_INET, &((const struct sockaddr_in&) address).sin_addr, text, sizeof(text));
+    else if (address.ss_family == AF_INET6)
+        inet_ntop(AF_INET6, &((const struct sockaddr_in6&) address).sin6_addr, text, sizeof(text));
+    else
+        return "unix";
+    return text;
+}
+
+static void watch(int epoll, int fd)
+{
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) < 0)
+        throw std::runtime_error("Could not watch socket: " + std::string(strerror(errno)));
+}
+
+Relay::Relay(const Options& options, const WriterFactory& factory) :
+        _options(options),
+        _factory(factory),
+        _unix(-1),
+        _reportedTime(0)
+{
+    if (_options.threads == 0)
+        throw std::runtime_error("The relay needs at least one thread.");
+    if (pipe2(_wake, O_NONBLOCK | O_CLOEXEC) < 0)
+        throw std::runtime_error("Could not create pipe: " + std::string(strerror(errno)));
+    try
+    {
+        // The default writer exists from the start, for the statistics.
+        writer("");
+        if (!_options.socketPath.empty())
+        {
+            struct sockaddr_un addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            if (_options.socketPath.size() >= sizeof(addr.sun_path))
+                throw std::runtime_error("Socket path too long: " + _options.socketPath);
+            strcpy(addr.sun_path, _options.socketPath.c_str());
+            unlink(_options.socketPath.c_str());
+            _unix = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (_unix < 0 || bind(_unix, (struct sockaddr*) &addr, sizeof(addr)) < 0 || listen(_unix, 128) < 0)
+                throw std::runtime_error("Could not listen on " + _options.socketPath + ": "
+                        + std::string(strerror(errno)));
+        }
+        for (unsigned int t = 0; t < _options.threads; ++t)
+        {
+            std::unique_ptr<Worker> worker(new Worker());
+            worker->udp = -1;
+            worker->tcp = -1;
+            worker->epoll = epoll_create1(EPOLL_CLOEXEC);
+            if (worker->epoll < 0)
+                throw std::runtime_error("Could not create epoll instance: " + std::string(strerror(errno)));
+            _workers.push_back(std::move(worker));
+            Worker& w = *_workers.back();
+            w.buffer.resize(DATAGRAMS * MAX_DATAGRAM);
+            watch(w.epoll, _wake[0]);
+            if (_options.udpPort != 0)
+            {
+                w.udp = bindSocket(_options.address, _options.udpPort, SOCK_DGRAM);
+                watch(w.epoll, w.udp);
+            }
+            if (_options.tcpPort != 0)
+            {
+                w.tcp = bindSocket(_options.address, _options.tcpPort, SOCK_STREAM);
+                watch(w.epoll, w.tcp);
+            }
+            if (t == 0 && _unix >= 0)
+                watch(w.epoll, _unix);
+        }
+    }
+    catch (...)
+    {
+        _close();
+        throw;
+    }
+    for (auto&& worker : _workers)
+        worker->thread = std::thread(&Relay::_run, this, std::ref(*worker));
+}
+
+Relay::~Relay()
+{
+    char c = 0;
+    if (write(_wake[1], &c, 1) < 0)
+    {
+        // The pipe is never full, nothing to do.
+    }
+    for (auto&& worker : _workers)
+        worker->thread.join();
+    _close();
+    // The writers flush what they have queued.
+    _writers.clear();
+}
+
+void Relay::_close()
+{
+    for (auto&& worker : _workers)
+    {
+        for (auto&& c : worker->connections)
+            close(c.first);
+        if (worker->udp >= 0)
+            close(worker->udp);
+        if (worker->tcp >= 0)
+            close(worker->tcp);
+        close(worker->epoll);
+    }
+    _workers.clear();
+    if (_unix >= 0)
+    {
+        close(_unix);
+        unlink(_options.socketPath.c_str());
+    }
+    _unix = -1;
+    close(_wake[0]);
+    close(_wake[1]);
+}
+
+InfluxdbWriter& Relay::writer(const std::string& retentionPolicy)
+{
+    if (!_accepts(retentionPolicy))
+        throw std::runtime_error("Retention policy " + retentionPolicy + " is not accepted.");
+    std::lock_guard<std::mutex> lock(_writersMutex);
+    std::unique_ptr<InfluxdbWriter>& writer = _writers[retentionPolicy];
+    if (!writer)
+        writer = _factory(retentionPolicy);
+    return *writer;
+}
+
+InfluxdbWriter& Relay::_writer(Worker& worker, const std::string& retentionPolicy)
+{
+    // Workers look up their own copy, without locking.
+    auto it = worker.writers.find(retentionPolicy);
+    if (it != worker.writers.end())
+        return *it->second;
+    InfluxdbWriter& w = writer(retentionPolicy);
+    worker.writers[retentionPolicy] = &w;
+    return w;
+}
+
+bool Relay::_accepts(const std::string& retentionPolicy) const
+{
+    return retentionPolicy.empty() || _options.retentionPolicies.count(retentionPolicy) > 0;
+}
+
+void Relay::_run(Worker& worker)
+{
+    struct epoll_event events[64];
+    for (;;)
+    {
+        int n = epoll_wait(worker.epoll, events, 64, -1);
+        if (n < 0 && errno != EINTR)
+        {
+            std::cerr << "Relay: " << strerror(errno) << std::endl;
+            return;
+        }
+        for (int i = 0; i < n; ++i)
+        {
+            const int fd = events[i].data.fd;
+            if (fd == _wake[0])
+                return;
+            if (fd == worker.udp)
+                _receive(worker);
+            else if (fd == worker.tcp || fd == _unix)
+                _accept(worker, fd);
+            else
+            {
+                auto it = worker.connections.find(fd);
+                if (it == worker.connections.end())
+                    continue;
+                Connection& c = it->second;
+                try
+                {
+                    if (_read(worker, c))
+                        continue;
+                    // A last line without newline is still a line.
+                    if (c.mode == Connection::Lines && !c.input.empty())
+                    {
+                        _count(worker, c.source, c.input.data(), c.input.size(), false);
+                        _writer(worker, "").write(c.input.data(), c.input.size());
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    // E.g. no writer for the retention policy of a frame.
+                    std::cerr << "Relay: " << c.source << ": " << e.what() << std::endl;
+                    _count(worker, c.source, nullptr, 0, true);
+                }
+                close(fd);
+                worker.connections.erase(it);
+            }
+        }
+    }
+}
+
+void Relay::_receive(Worker& worker)
+{
+    struct mmsghdr messages[DATAGRAMS];
+    struct iovec parts[DATAGRAMS];
+    struct sockaddr_storage addresses[DATAGRAMS];
+    // Bounded, so that the connections of this worker get their turn.
+    for (int round = 0; round < 8; ++round)
+    {
+        memset(messages, 0, sizeof(messages));
+        for (unsigned int i = 0; i < DATAGRAMS; ++i)
+        {
+            parts[i].iov_base = &worker.buffer[i * MAX_DATAGRAM];
+            parts[i].iov_len = MAX_DATAGRAM;
+            messages[i].msg_hdr.msg_iov = &parts[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_name = &addresses[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(addresses[i]);
+        }
+        int n = recvmmsg(worker.udp, messages, DATAGRAMS, MSG_DONTWAIT, nullptr);
+        if (n <= 0)
+            return;
+        InfluxdbWriter& writer = _writer(worker, "");
+        for (int i = 0; i < n; ++i)
+        {
+            const char* data = (const char*) parts[i].iov_base;
+            const size_t size = messages[i].msg_len;
+            _count(worker, peerAddress(addresses[i]), data, size, false);
+            writer.write(data, size);
+        }
+        if ((unsigned int) n < DATAGRAMS)
+            return;
+    }
+}
+
+void Relay::_accept(Worker& worker, int listener)
+{
+    for (;;)
+    {
+        struct sockaddr_storage address;
+        socklen_t size = sizeof(address);
+        int fd = accept4(listener, (struct sockaddr*) &address, &size, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+        const std::string source = listener == _unix ? "unix" : peerAddress(address);
+        if (worker.connections.size() >= MAX_CONNECTIONS)
+        {
+            _count(worker, source, nullptr, 0, true);
+            close(fd);
+            continue;
+        }
+        watch(worker.epoll, fd);
+        Connection& c = worker.connections[fd];
+        c.fd = fd;
+        c.source = source;
+        c.mode = Connection::Unknown;
+    }
+}
+
+bool Relay::_read(Worker& worker, Connection& connection)
+{
+    ssize_t n = read(connection.fd, worker.buffer.data(), MAX_DATAGRAM);
+    if (n < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    if (n == 0)
+        return false;
+    connection.input.append(worker.buffer.data(), n);
+    return _handle(worker, connection);
+}
+
+bool Relay::_handle(Worker& worker, Connection& connection)
+{
+    std::string& input = connection.input;
+    if (connection.mode == Connection::Unknown)
+        connection.mode = input[0] == 0 ? Connection::Frames : Connection::Lines;
+
+    if (connection.mode == Connection::Lines)
+    {
+        size_t end = input.rfind('\n');
+        if (end == std::string::npos)
+        {
+            if (input.size() <= _options.maxFrame)
+                return true;
+            _count(worker, connection.source, nullptr, 0, true);
+            return false;
+        }
+        _count(worker, connection.source, input.data(), end + 1, false);
+        _writer(worker, "").write(input.data(), end + 1);
+        input.erase(0, end + 1);
+        return true;
+    }
+
+    size_t offset = 0;
+    bool ok = true;
+    std::string retentionPolicy;
+    while (input.size() - offset >= 4)
+    {
+        const unsigned char* p = (const unsigned char*) input.data() + offset;
+        const size_t length = (size_t) p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+        if (length < 2 || length > _options.maxFrame)
+        {
+            ok = false;
+            break;
+        }
+        if (input.size() - offset < 4 + length)
+            break;
+        if (p[4] != FrameTransport::VERSION || 2u + p[5] > length)
+        {
+            ok = false;
+            break;
+        }
+        retentionPolicy.assign((const char*) p + 6, p[5]);
+        if (!_accepts(retentionPolicy))
+        {
+            ok = false;
+            break;
+        }
+        const char* lines = (const char*) p + 6 + p[5];
+        const size_t size = length - 2 - p[5];
+        _count(worker, connection.source, lines, size, false);
+        _writer(worker, retentionPolicy).write(lines, size);
+        offset += 4 + length;
+    }
+    input.erase(0, offset);
+    if (!ok)
+        _count(worker, connection.source, nullptr, 0, true);
+    return ok;
+}
+
+void Relay::_count(Worker& worker, const std::string& source, const char* data, size_t size, bool error)
+{
+    unsigned long long lines = size > 0 ? std::count(data, data + size, '\n') + (data[size - 1] != '\n') : 0;
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    Source& s = worker.sources[source];
+    if (error)
+    {
+        s.errors++;
+        return;
+    }
+    s.lines += lines;
+    s.bytes += size;
+    s.batches++;
+}
+
+std::map<std::string, Relay::Source> Relay::sources()
+{
+    std::map<std::string, Source> total;
+    for (auto&& worker : _workers)
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        for (auto&& p : worker->sources)
+        {
+            Source& s = total[p.first];
+            s.lines += p.second.lines;
+            s.bytes += p.second.bytes;
+            s.batches += p.second.batches;
+            s.errors += p.second.errors;
+        }
+    }
+    return total;
+}
+
+void Relay::writeStats(LineProtocol& lines, long long timestamp)
+{
+    const double seconds = (timestamp - _reportedTime) * 1e-9;
+    for (auto&& p : sources())
+    {
+        unsigned long long& reported = _reported[p.first];
+        lines.begin("powermon_relay")
+                .tag("source", p.first.c_str())
+                .field("lines", (long long) p.second.lines)
+                .field("bytes", (long long) p.second.bytes)
+                .field("batches", (long long) p.second.batches)
+                .field("errors", (long long) p.second.errors);
+        if (_reportedTime != 0 && seconds > 0.0)
+            lines.field("rate", (p.second.lines - reported) / seconds);
+        lines.end(timestamp);
+        reported = p.second.lines;
+    }
+    _reportedTime = timestamp;
+}
+
+Relay::Options readRelayOptions(Configuration& conf)
+{
+    Relay::Options options;
+    options.address = conf.get("PowerMonitor.relay.address", options.address);
+    options.udpPort = conf.get("PowerMonitor.relay.udpport", options.udpPort);
+    options.tcpPort = conf.get("PowerMonitor.relay.tcpport", options.tcpPort);
+    options.socketPath = conf.get("PowerMonitor.relay.socket", options.socketPath);
+    options.threads = conf.get("PowerMonitor.relay.threads", options.threads);
+    options.maxFrame = conf.get("PowerMonitor.relay.maxframe", options.maxFrame);
+    if (conf.has("PowerMonitor.relay.retentionpolicies"))
+    {
+        for (auto&& name : conf.getArray<std::string>("PowerMonitor.relay.retentionpolicies"))
+        {
+            // Names also become part of spool file names.
+            if (name.empty() || name.size() > 255 || name.find('/') != std::string::npos)
+                throw std::runtime_error("Invalid relay retention policy '" + name + "'.");
+            options.retentionPolicies.insert(name);
+        }
+    }
+    return options;
+}
+
+} /* namespace PowerMonitor */
@@ -0,0 +1,165 @@
+/*
+ * Relay.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RELAY_H_
+#define RELAY_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "InfluxdbWriter.h"
+#include "LineProtocol.h"
+
+namespace PowerMonitor
+{
+
+class Configuration;
+
+//! Fans in the writes of many meters into a few large InfluxDB batches.
+//!
+//! Meters write to the relay with the udp://, tcp:// or unix: transports.
+//! UDP datagrams hold lines. A stream connection holds frames as written
+//! by FrameTransport, or plain lines; the first byte tells them apart, as
+//! a frame starts with the high byte of its length, which is 0.
+//!
+//! Each worker thread runs its own epoll loop with its own UDP socket and
+//! TCP listener, bound to the same port with SO_REUSEPORT, so the kernel
+//! spreads datagrams and connections over the workers without any locking
+//! between them. The Unix socket is served by the first worker. Received
+//! lines go straight into the InfluxdbWriter of their retention policy,
+//! which batches them and keeps its connection open. Only the default and
+//! the configured retention policies are accepted, as every policy gets a
+//! writer of its own; a frame naming any other one is counted as an error
+//! of its source and closes the connection.
+//!
+//! Lines, bytes, batches and errors are counted per source address, on
+//! per-worker counters that are only summed up for the statistics.
+//!
+class Relay
+{
+public:
+    //! Listening settings.
+    struct Options
+    {
+        Options() :
+            address("0.0.0.0"),
+            udpPort(8089),
+            tcpPort(8094),
+            threads(2),
+            maxFrame(16 * 1024 * 1024)
+        {
+        }
+        std::string address;        //!< Address to listen on.
+        unsigned int udpPort;       //!< UDP port, 0 for none.
+        unsigned int tcpPort;       //!< TCP port, 0 for none.
+        std::string socketPath;     //!< Unix socket path, empty for none.
+        unsigned int threads;       //!< Number of worker threads.
+        size_t maxFrame;            //!< Largest frame or line accepted in bytes.
+        std::set<std::string> retentionPolicies;    //!< Retention policies accepted besides the default.
+    };
+
+    //! Creates the writer for a retention policy, empty for the default.
+    typedef std::function<std::unique_ptr<InfluxdbWriter>(const std::string&)> WriterFactory;
+
+    //! Counters of one source.
+    struct Source
+    {
+        unsigned long long lines;   //!< Lines received.
+        unsigned long long bytes;   //!< Bytes received.
+        unsigned long long batches; //!< Datagrams and frames received.
+        unsigned long long errors;  //!< Malformed frames and rejected connections.
+    };
+
+    //! Constructor, opens the sockets and starts the worker threads.
+    //! \param options listening settings.
+    //! \param factory creates the writers.
+    Relay(const Options& options, const WriterFactory& factory);
+    //! Destructor, stops the workers, then flushes and closes the writers.
+    ~Relay();
+
+    //! Gets the counters of all sources so far.
+    std::map<std::string, Source> sources();
+
+    //! Writes a powermon_relay point per source with its counters and the
+    //! line rate since the previous call.
+    //! \param lines buffer to append to.
+    //! \param timestamp timestamp in nanoseconds since Unix epoch.
+    void writeStats(LineProtocol& lines, long long timestamp);
+
+    //! Gets the writer of a retention policy, creating it if needed.
+    //! \param retentionPolicy retention policy, empty for the default.
+    //! \throw std::runtime_error if the retention policy is not accepted.
+    InfluxdbWriter& writer(const std::string& retentionPolicy);
+
+private:
+    //! Stream connection.
+    struct Connection
+    {
+        //! What the connection carries.
+        enum Mode
+        {
+            Unknown,    //!< Nothing received yet.
+            Frames,     //!< FrameTransport frames.
+            Lines       //!< Plain lines.
+        };
+
+        int             fd;         //!< Socket.
+        std::string     source;     //!< Peer address.
+        Mode            mode;       //!< What it carries.
+        std::string     input;      //!< Received data not yet handled.
+    };
+
+    //! Worker thread with its sockets and counters.
+    struct Worker
+    {
+        int                                     epoll;      //!< Epoll instance.
+        int                                     udp;        //!< UDP socket or -1.
+        int                                     tcp;        //!< TCP listener or -1.
+        std::map<int, Connection>               connections;//!< Connections by socket.
+        std::map<std::string, InfluxdbWriter*>  writers;    //!< Writers used so far.
+        std::vector<char>                       buffer;     //!< Receive buffer.
+        std::mutex                              mutex;      //!< Guards sources.
+        std::map<std::string, Source>           sources;    //!< Counters by source.
+        std::thread                             thread;     //!< Worker thread.
+    };
+
+    Relay(const Relay&);
+    Relay& operator=(const Relay&);
+
+    void _run(Worker& worker);
+    void _receive(Worker& worker);
+    void _accept(Worker& worker, int listener);
+    bool _read(Worker& worker, Connection& connection);
+    bool _handle(Worker& worker, Connection& connection);
+    void _count(Worker& worker, const std::string& source, const char* data, size_t size, bool error);
+    InfluxdbWriter& _writer(Worker& worker, const std::string& retentionPolicy);
+    bool _accepts(const std::string& retentionPolicy) const;
+    void _close();
+
+    Options                                             _options;
+    WriterFactory                                       _factory;
+    std::mutex                                          _writersMutex;  //!< Guards _writers.
+    std::map<std::string, std::unique_ptr<InfluxdbWriter> > _writers;   //!< Writers by retention policy.
+    std::vector<std::unique_ptr<Worker> >               _workers;
+    int                                                 _unix;          //!< Unix listener or -1.
+    int                                                 _wake[2];       //!< Pipe to stop the workers.
+    std::map<std::string, unsigned long long>           _reported;      //!< Lines at the previous writeStats().
+    long long                                           _reportedTime;  //!< Time of the previous writeStats().
+};
+
+//! Reads the relay settings from PowerMonitor.relay.
+//! \param conf configuration.
+//! \return Settings.
+Relay::Options readRelayOptions(Configuration& conf);
+
+} /* namespace PowerMonitor */
+
+#endif /* RELAY_H_ */
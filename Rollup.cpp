@@ -0,0 +1,149 @@
+/*
+ * Rollup.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+#include "Configuration.h"
+#include "Rollup.h"
+
+namespace PowerMonitor
+{
+
+// Channels of a tier: voltage, frequency, then the power of each circuit.
+static const unsigned int VOLTAGE = 0;
+static const unsigned int FREQUENCY = 1;
+static const unsigned int FIRST_CIRCUIT = 2;
+
+static const long long NS_PER_S = 1000000000LL;
+
+//! Gets the end of the window of the given length the time falls into.
+static long long windowEnd(long long time, long long length)
+{
+    long long end = time / length * length;
+    return end < time ? end + length : end;
+}
+
+void Rollup::Aggregate::add(double value, double seconds)
+{
+    min = std::min(min, value);
+    max = std::max(max, value);
+    integral += value * seconds;
+    last = value;
+}
+
+void Rollup::Aggregate::merge(const Aggregate& other)
+{
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    integral += other.integral;
+    last = other.last;
+}
+
+Rollup::Rollup(const std::vector<Tier>& tiers, const std::vector<std::string>& circuits) :
+        _circuits(circuits.size())
+{
+    const Aggregate empty = { HUGE_VAL, -HUGE_VAL, 0.0, 0.0 };
+    for (size_t t = 0; t < tiers.size(); ++t)
+    {
+        if (tiers[t].interval == 0)
+            throw std::runtime_error("Rollup interval must be positive.");
+        if (t > 0 && tiers[t].interval % tiers[t - 1].interval != 0)
+            throw std::runtime_error("Rollup interval " + std::to_string(tiers[t].interval)
+                    + " s is not a multiple of the previous one.");
+        State s;
+        s.config = tiers[t];
+        s.length = tiers[t].interval * NS_PER_S;
+        s.end = 0;
+        s.seconds = 0.0;
+        s.current.assign(FIRST_CIRCUIT + _circuits, empty);
+        s.prefixes.emplace_back(s.config.measurement, std::map<std::string, std::string> { { "channel", "voltage" } });
+        s.prefixes.emplace_back(s.config.measurement, std::map<std::string, std::string> { { "channel", "frequency" } });
+        for (auto&& name : circuits)
+            s.prefixes.emplace_back(s.config.measurement, std::map<std::string, std::string> { { "channel", name } });
+        _tiers.push_back(s);
+    }
+}
+
+void Rollup::add(const BlockResult& result, double seconds)
+{
+    for (auto&& s : _tiers)
+        s.lines.clear();
+    if (_tiers.empty())
+        return;
+    State& s = _tiers[0];
+    if (s.end != 0 && result.timestamp > s.end)
+        _close(0);
+    if (s.end == 0)
+        s.end = windowEnd(result.timestamp, s.length);
+    s.current[VOLTAGE].add(result.vRMS, seconds);
+    s.current[FREQUENCY].add(result.frequency, seconds);
+    for (unsigned int i = 0; i < _circuits; ++i)
+        s.current[FIRST_CIRCUIT + i].add(result.power[i], seconds);
+    s.seconds += seconds;
+}
+
+void Rollup::_close(unsigned int t)
+{
+    State& s = _tiers[t];
+    const long long boundary = s.end;
+    const double seconds = s.seconds;
+    _done.swap(s.current);
+    s.current.assign(_done.size(), Aggregate { HUGE_VAL, -HUGE_VAL, 0.0, 0.0 });
+    s.seconds = 0.0;
+    s.end = 0;
+    if (seconds <= 0.0)
+        return;
+    for (size_t c = 0; c < _done.size(); ++c)
+    {
+        const Aggregate& a = _done[c];
+        s.lines.begin(s.prefixes[c])
+                .field("min", a.min)
+                .field("max", a.max)
+                .field("mean", a.integral / seconds)
+                .field("last", a.last);
+        if (c >= FIRST_CIRCUIT)
+            s.lines.field("energy", a.integral / 3600.0);
+        s.lines.end(boundary - s.length);
+    }
+    if (t + 1 == _tiers.size())
+        return;
+
+    // Feed the completed window to the next tier.
+    State& next = _tiers[t + 1];
+    if (next.end != 0 && boundary > next.end)
+    {
+        // The next tier still holds an older window, close it first.
+        std::vector<Aggregate> done;
+        done.swap(_done);
+        _close(t + 1);
+        _done.swap(done);
+    }
+    if (next.end == 0)
+        next.end = windowEnd(boundary, next.length);
+    for (size_t c = 0; c < _done.size(); ++c)
+        next.current[c].merge(_done[c]);
+    next.seconds += seconds;
+    if (boundary == next.end)
+        _close(t + 1);
+}
+
+std::vector<Rollup::Tier> readRollupTiers(Configuration& conf)
+{
+    std::vector<Rollup::Tier> tiers;
+    for (auto&& item : conf.getObjects("PowerMonitor.rollups"))
+    {
+        Rollup::Tier tier;
+        tier.interval = item.get<unsigned int>("interval");
+        tier.measurement = item.get("measurement", "rollup_" + std::to_string(tier.interval) + "s");
+        tier.retention = item.get<std::string>("retention", "");
+        tiers.push_back(tier);
+    }
+    return tiers;
+}
+
+} /* namespace PowerMonitor */
@@ -0,0 +1,114 @@
+/*
+ * Rollup.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef ROLLUP_H_
+#define ROLLUP_H_
+
+#include <string>
+#include <vector>
+#include "BlockProcessor.h"
+#include "LineProtocol.h"
+
+namespace PowerMonitor
+{
+
+class Configuration;
+
+//! Aggregates results over tiers of increasingly long intervals.
+//!
+//! The voltage, the frequency and the power of every circuit are reduced
+//! to their minimum, maximum, time weighted mean and last value, and the
+//! energy of every circuit is summed. The first tier takes every result of
+//! the processor, each further tier takes the completed aggregates of the
+//! tier before it, so every result costs O(1) per tier and channel. Each
+//! interval must be a multiple of the one before so that the windows nest.
+//!
+//! Windows are aligned to multiples of the interval since the Unix epoch
+//! and are stamped with their start time, like InfluxDB GROUP BY time().
+//! A result belongs to the window its timestamp falls into. The first
+//! window after startup and windows around gaps are partial.
+//!
+class Rollup
+{
+public:
+    //! One aggregation tier.
+    struct Tier
+    {
+        unsigned int    interval;       //!< Window length in seconds.
+        std::string     measurement;    //!< Measurement to write to.
+        std::string     retention;      //!< InfluxDB retention policy, empty for the default.
+    };
+
+    //! Constructor.
+    //! \param tiers tiers from the shortest interval to the longest.
+    //! \param circuits circuit names in result order.
+    Rollup(const std::vector<Tier>& tiers, const std::vector<std::string>& circuits);
+
+    //! Adds the results of a reporting window.
+    //! \param result results to add.
+    //! \param seconds length of the reporting window in seconds.
+    void add(const BlockResult& result, double seconds);
+
+    //! Gets the number of tiers.
+    unsigned int tiers() const
+    {
+        return _tiers.size();
+    }
+
+    //! Gets the configuration of a tier.
+    const Tier& tier(unsigned int t) const
+    {
+        return _tiers[t].config;
+    }
+
+    //! Gets the windows of a tier completed by the last add(), one point
+    //! per channel and window. Usually empty, more than one window only
+    //! after a gap in the results.
+    const LineProtocol& lines(unsigned int t) const
+    {
+        return _tiers[t].lines;
+    }
+
+private:
+    //! Running aggregate of one quantity.
+    struct Aggregate
+    {
+        double min;         //!< Smallest value.
+        double max;         //!< Largest value.
+        double integral;    //!< Sum of value times seconds.
+        double last;        //!< Newest value.
+
+        void add(double value, double seconds);
+        void merge(const Aggregate& other);
+    };
+
+    //! State of one tier.
+    struct State
+    {
+        Tier                        config;         //!< Configuration.
+        long long                   length;         //!< Interval in nanoseconds.
+        long long                   end;            //!< End of the current window.
+        double                      seconds;        //!< Time covered by the current window.
+        std::vector<Aggregate>      current;        //!< Current window per channel.
+        std::vector<LineProtocol::Prefix> prefixes; //!< Point prefix per channel.
+        LineProtocol                lines;          //!< Windows completed by the last add().
+    };
+
+    void _close(unsigned int t);
+
+    std::vector<Aggregate>      _done;          //!< Window being closed, per channel.
+    std::vector<State>          _tiers;         //!< Tiers, shortest first.
+    unsigned int                _circuits;      //!< Number of circuits.
+};
+
+//! Reads the aggregation tiers from PowerMonitor.rollups, see Rollup.
+//! \param conf configuration.
+//! \return Tiers, empty if none are configured.
+std::vector<Rollup::Tier> readRollupTiers(Configuration& conf);
+
+} /* namespace PowerMonitor */
+
+#endif /* ROLLUP_H_ */
@@ -0,0 +1,59 @@
+/*
+ * SampleBlock.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SAMPLEBLOCK_H_
+#define SAMPLEBLOCK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace PowerMonitor
+{
+
+//! Block of raw ADC samples stored one contiguous array per channel.
+struct SampleBlock
+{
+    //! Constructor.
+    //! \param nChannels number of channels.
+    //! \param capacity maximum number of samples per channel.
+    SampleBlock(unsigned int nChannels = 0, size_t capacity = 0) :
+            timestamp(0),
+            size(0),
+            capacity(capacity),
+            scale(nChannels, 1.f),
+            offset(nChannels, 0.f),
+            samples(nChannels * capacity)
+    {
+    }
+
+    //! Gets the number of channels.
+    unsigned int channels() const
+    {
+        return scale.size();
+    }
+    //! Gets the raw samples of a channel.
+    int16_t* channel(unsigned int i)
+    {
+        return &samples[i * capacity];
+    }
+    //! Gets the raw samples of a channel.
+    const int16_t* channel(unsigned int i) const
+    {
+        return &samples[i * capacity];
+    }
+
+    long long               timestamp;  //!< Time of the last sample in nanoseconds since Unix epoch.
+    size_t                  size;       //!< Number of samples per channel.
+    size_t                  capacity;   //!< Maximum number of samples per channel.
+    std::vector<float>      scale;      //!< Millivolts per raw count for each channel.
+    std::vector<float>      offset;     //!< Offset in raw counts for each channel.
+    std::vector<int16_t>    samples;    //!< Raw samples, capacity per channel.
+};
+
+} /* namespace PowerMonitor */
+
+#endif /* SAMPLEBLOCK_H_ */
@@ -0,0 +1,78 @@
+/*
+ * SampleConversion.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "SampleConversion.h"
+
+namespace PowerMonitor
+{
+
+namespace
+{
+
+inline int16_t decode(const unsigned char* p, const SampleFormat& format)
+{
+    uint16_t raw = format.isBigEndian ? (p[0] << 8 | p[1]) : (p[1] << 8 | p[0]);
+    raw >>= format.shift;
+    if (format.bits < 16)
+    {
+        uint16_t mask = (1u << format.bits) - 1;
+        raw &= mask;
+        if (format.isSigned && (raw & (1u << (format.bits - 1))))
+            raw |= ~mask;
+    }
+    return (int16_t) raw;
+}
+
+}
+
+void deinterleave(const char* start, ptrdiff_t step, size_t count,
+        const ChannelLayout* layouts, unsigned int nChannels, int16_t* const* out)
+{
+    const unsigned char* row = (const unsigned char*) start;
+    for (size_t i = 0; i < count; ++i, row += step)
+    {
+        for (unsigned int c = 0; c < nChannels; ++c)
+            out[c][i] = decode(row + layouts[c].offset, layouts[c].format);
+    }
+}
+
+void convertSamples(const int16_t* in, float* out, size_t count, float scale, float offset)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 voffset = _mm256_set1_ps(offset);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i raw = _mm_loadu_si128((const __m128i*) (in + i));
+        __m256 v = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(raw));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_add_ps(v, voffset), vscale));
+    }
+#elif defined(__SSE2__)
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 voffset = _mm_set1_ps(offset);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i raw = _mm_loadu_si128((const __m128i*) (in + i));
+        // Sign extend to 32 bits by unpacking into the upper halves.
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(raw, raw), 16);
+        __m128 vlo = _mm_cvtepi32_ps(lo);
+        __m128 vhi = _mm_cvtepi32_ps(hi);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_add_ps(vlo, voffset), vscale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_add_ps(vhi, voffset), vscale));
+    }
+#endif
+    for (; i < count; ++i)
+        out[i] = ((float) in[i] + offset) * scale;
+}
+
+} /* namespace PowerMonitor */
@@ -0,0 +1,58 @@
+/*
+ * SampleConversion.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SAMPLECONVERSION_H_
+#define SAMPLECONVERSION_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace PowerMonitor
+{
+
+//! Storage format of a sample in an interleaved ADC buffer.
+struct SampleFormat
+{
+    unsigned int bits;      //!< Number of valid bits.
+    unsigned int shift;     //!< Right shift to apply to the stored value.
+    bool isSigned;          //!< Sign extend the valid bits?
+    bool isBigEndian;       //!< Stored in big endian byte order?
+};
+
+//! Location and format of one channel in an interleaved ADC buffer.
+struct ChannelLayout
+{
+    ptrdiff_t offset;       //!< Byte offset of the first sample from buffer start.
+    SampleFormat format;    //!< Storage format, 16-bit storage is assumed.
+};
+
+//! De-interleaves 16-bit samples of several channels into contiguous arrays.
+//!
+//! The buffer is walked once, one sample row at a time, so that every
+//! cache line of the interleaved data is touched only once.
+//! \param start start of the interleaved buffer.
+//! \param step distance between two consecutive samples of a channel in bytes.
+//! \param count number of samples per channel.
+//! \param layouts layout of each channel to extract.
+//! \param nChannels number of channels to extract.
+//! \param out destination array for each channel, each holding count samples.
+void deinterleave(const char* start, ptrdiff_t step, size_t count,
+        const ChannelLayout* layouts, unsigned int nChannels, int16_t* const* out);
+
+//! Converts raw samples to physical units.
+//!
+//! Computes (raw + offset) * scale for each sample. Uses SSE2 or AVX2 when
+//! the compiler targets them; all code paths give identical results.
+//! \param in raw samples.
+//! \param out converted samples.
+//! \param count number of samples.
+//! \param scale scale factor.
+//! \param offset offset added to the raw value before scaling.
+void convertSamples(const int16_t* in, float* out, size_t count, float scale, float offset);
+
+} /* namespace PowerMonitor */
+
+#endif /* SAMPLECONVERSION_H_ */
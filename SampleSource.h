@@ -0,0 +1,48 @@
+/*
+ * SampleSource.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SAMPLESOURCE_H_
+#define SAMPLESOURCE_H_
+
+#include "SampleBlock.h"
+
+namespace PowerMonitor
+{
+
+//! Source of raw sample blocks for the processing pipeline.
+//!
+//! Blocks hold the channels in BlockProcessor channel order. A block
+//! obtained with next() stays valid until release() is called.
+//!
+class SampleSource
+{
+public:
+    virtual ~SampleSource()
+    {
+    }
+
+    //! Starts producing blocks.
+    virtual void start() = 0;
+    //! Stops producing blocks.
+    virtual void stop() = 0;
+
+    //! Waits for the next block.
+    //! \param timeoutMs maximum time to wait in milliseconds.
+    //! \return Next block or nullptr on timeout or when finished.
+    virtual const SampleBlock* next(unsigned int timeoutMs) = 0;
+    //! Returns the block obtained with next().
+    virtual void release() = 0;
+
+    //! Has the source run out of blocks?
+    virtual bool finished() const
+    {
+        return false;
+    }
+};
+
+} /* namespace PowerMonitor */
+
+#endif /* SAMPLESOURCE_H_ */
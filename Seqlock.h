@@ -0,0 +1,86 @@
+/*
+ * Seqlock.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SEQLOCK_H_
+#define SEQLOCK_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace PowerMonitor
+{
+
+//! Single-writer sequence lock around a value.
+//!
+//! The writer never waits: it bumps the sequence number to odd, stores the
+//! value and bumps it back to even. Readers copy the value and retry when
+//! the sequence number was odd or changed meanwhile. The value is stored
+//! as relaxed atomic words so concurrent copies are well defined. T must
+//! be a trivial type.
+//!
+template<class T> class Seqlock
+{
+public:
+    Seqlock() :
+            _sequence(0)
+    {
+        T value = T();
+        write(value);
+    }
+
+    //! Publishes a new value. Only one thread may write.
+    void write(const T& value)
+    {
+        uint64_t words[WORDS] = { 0 };
+        memcpy(words, &value, sizeof(T));
+        unsigned int sequence = _sequence.load(std::memory_order_relaxed);
+        _sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (unsigned int i = 0; i < WORDS; ++i)
+            _words[i].store(words[i], std::memory_order_relaxed);
+        _sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    //! Reads a consistent copy of the value.
+    //! \param value set to the latest published value.
+    //! \return Sequence number of the value, changes with every write.
+    unsigned int read(T& value) const
+    {
+        uint64_t words[WORDS];
+        for (unsigned int attempt = 0;; ++attempt)
+        {
+            unsigned int before = _sequence.load(std::memory_order_acquire);
+            if ((before & 1) == 0)
+            {
+                for (unsigned int i = 0; i < WORDS; ++i)
+                    words[i] = _words[i].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (_sequence.load(std::memory_order_relaxed) == before)
+                {
+                    memcpy(&value, words, sizeof(T));
+                    return before / 2;
+                }
+            }
+            // The writer was preempted in the middle, let it finish.
+            if (attempt > 100)
+                std::this_thread::yield();
+        }
+    }
+
+private:
+    static_assert(std::is_trivial<T>::value, "Seqlock needs a trivial type.");
+    static const unsigned int WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<unsigned int>   _sequence;          //!< Odd while a write is in progress.
+    std::atomic<uint64_t>       _words[WORDS];      //!< The value.
+};
+
+} /* namespace PowerMonitor */
+
+#endif /* SEQLOCK_H_ */
@@ -0,0 +1,250 @@
+/*
+ * Spool.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Spool.h"
+
+namespace PowerMonitor
+{
+
+namespace
+{
+
+const char spoolMagic[8] = { 'P', 'M', 'S', 'P', 'O', 'O', 'L', '2' };
+const size_t headerSize = 4096;
+const uint32_t wrapMarker = 0xffffffff;   //!< Record length marking a wrap to the start.
+
+struct RecordHeader
+{
+    uint32_t length;    //!< Payload length in bytes.
+    uint32_t checksum;  //!< FNV-1a hash of the payload.
+};
+
+uint32_t checksum(const char* data, size_t size)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < size; ++i)
+    {
+        h ^= (unsigned char) data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+inline size_t padded(size_t size)
+{
+    return (sizeof(RecordHeader) + size + 7) & ~(size_t) 7;
+}
+
+inline size_t segmentEnd(size_t size)
+{
+    return headerSize + ((size - headerSize) & ~(size_t) 7);
+}
+
+inline bool validOffset(uint64_t offset, size_t size)
+{
+    return offset >= headerSize && offset < segmentEnd(size) && (offset - headerSize) % 8 == 0;
+}
+
+}
+
+struct Spool::Header
+{
+    char magic[8];
+    uint64_t size;      //!< Segment size in bytes.
+    uint64_t read;      //!< Offset of the oldest record or wrap marker.
+    uint64_t write;     //!< Offset past the newest record, equal to read when empty.
+};
+
+Spool::Spool(const std::string& path, size_t capacity) :
+        _fd(-1),
+        _map(nullptr),
+        _size(0),
+        _dataStart(headerSize),
+        _dataEnd(0)
+{
+    _fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (_fd < 0)
+    {
+        throw std::runtime_error("Could not open spool " + path + ": " + std::string(strerror(errno)));
+    }
+    struct stat st;
+    fstat(_fd, &st);
+    Header existing;
+    bool valid = st.st_size > (off_t) headerSize
+            && pread(_fd, &existing, sizeof(existing), 0) == (ssize_t) sizeof(existing)
+            && std::memcmp(existing.magic, spoolMagic, sizeof(spoolMagic)) == 0
+            && existing.size == (uint64_t) st.st_size
+            && validOffset(existing.read, existing.size) && validOffset(existing.write, existing.size);
+    _size = valid ? st.st_size : std::max(capacity, 2 * headerSize);
+    _dataEnd = segmentEnd(_size);
+    if (!valid && ftruncate(_fd, _size) < 0)
+    {
+        close(_fd);
+        throw std::runtime_error("Could not size spool " + path + ": " + std::string(strerror(errno)));
+    }
+    void* map = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (map == MAP_FAILED)
+    {
+        close(_fd);
+        throw std::runtime_error("Could not map spool " + path + ": " + std::string(strerror(errno)));
+    }
+    _map = (char*) map;
+    if (!valid)
+        _reset();
+}
+
+Spool::~Spool()
+{
+    msync(_map, _size, MS_SYNC);
+    munmap(_map, _size);
+    close(_fd);
+}
+
+Spool::Header* Spool::_header() const
+{
+    return (Header*) _map;
+}
+
+void Spool::_reset()
+{
+    Header* h = _header();
+    std::memcpy(h->magic, spoolMagic, sizeof(spoolMagic));
+    h->size = _size;
+    h->read = _dataStart;
+    h->write = _dataStart;
+    _commit();
+}
+
+void Spool::_commit()
+{
+    // The mapping is shared, so the page cache already holds the data if
+    // the process dies. Schedule writeback without blocking the sender.
+    msync(_map, _size, MS_ASYNC);
+}
+
+size_t Spool::_oldest(uint32_t& length) const
+{
+    const Header* h = _header();
+    size_t offset = h->read;
+    RecordHeader record;
+    std::memcpy(&record, _map + offset, sizeof(record));
+    if (h->read > h->write && record.length == wrapMarker)
+    {
+        offset = _dataStart;
+        std::memcpy(&record, _map + offset, sizeof(record));
+    }
+    // A record lies before the write offset, or before the end of the
+    // segment when the ring has wrapped.
+    const size_t limit = offset > h->write ? _dataEnd : h->write;
+    if (offset == h->write || record.length == wrapMarker || offset + padded(record.length) > limit)
+        return _size;
+    length = record.length;
+    return offset;
+}
+
+size_t Spool::_advance(size_t offset, uint32_t length) const
+{
+    offset += padded(length);
+    return offset == _dataEnd ? _dataStart : offset;
+}
+
+bool Spool::empty() const
+{
+    return _header()->read == _header()->write;
+}
+
+size_t Spool::used() const
+{
+    const Header* h = _header();
+    if (h->read <= h->write)
+        return h->write - h->read;
+    return (_dataEnd - h->read) + (h->write - _dataStart);
+}
+
+bool Spool::append(const char* data, size_t size)
+{
+    Header* h = _header();
+    const size_t needed = padded(size);
+    if (size >= wrapMarker || needed >= capacity())
+        return false;
+    // Only free space is written to. The write offset must not reach the
+    // oldest record, as the ring would then look empty.
+    size_t offset = h->write;
+    bool fits;
+    if (h->read > h->write)
+        fits = offset + needed < h->read;
+    else if (offset + needed <= _dataEnd)
+        fits = _advance(offset, size) != h->read;
+    else
+    {
+        offset = _dataStart;
+        fits = offset + needed < h->read;
+    }
+    if (!fits)
+        return false;
+    if (offset != h->write)
+    {
+        // Continue at the start, the reader follows the marker.
+        const RecordHeader marker = { wrapMarker, 0 };
+        std::memcpy(_map + h->write, &marker, sizeof(marker));
+    }
+    RecordHeader record = { (uint32_t) size, checksum(data, size) };
+    std::memcpy(_map + offset, &record, sizeof(record));
+    std::memcpy(_map + offset + sizeof(record), data, size);
+    // Publish the record only after it is completely written.
+    std::atomic_signal_fence(std::memory_order_release);
+    h->write = _advance(offset, size);
+    _commit();
+    return true;
+}
+
+bool Spool::front(const char*& data, size_t& size)
+{
+    Header* h = _header();
+    while (h->read != h->write)
+    {
+        uint32_t length;
+        const size_t offset = _oldest(length);
+        if (offset == _size)
+        {
+            // Corrupt tail, nothing after it can be trusted.
+            h->read = h->write;
+            _commit();
+            return false;
+        }
+        RecordHeader record;
+        std::memcpy(&record, _map + offset, sizeof(record));
+        data = _map + offset + sizeof(record);
+        size = length;
+        if (checksum(data, size) == record.checksum)
+            return true;
+        // Skip a torn record.
+        h->read = _advance(offset, length);
+    }
+    return false;
+}
+
+void Spool::pop()
+{
+    Header* h = _header();
+    if (h->read == h->write)
+        return;
+    uint32_t length;
+    const size_t offset = _oldest(length);
+    h->read = offset == _size ? h->write : _advance(offset, length);
+    _commit();
+}
+
+} /* namespace PowerMonitor */
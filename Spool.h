@@ -0,0 +1,84 @@
+/*
+ * Spool.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SPOOL_H_
+#define SPOOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace PowerMonitor
+{
+
+//! Crash-safe on-disk FIFO of write batches.
+//!
+//! Records are appended to a memory-mapped segment file of fixed size,
+//! used as a ring. Each record carries its length and a checksum. A record
+//! that does not fit before the end of the segment goes to its start, after
+//! a wrap marker in place of the next record header. Records are only
+//! written to free space and the header holding the read and write offsets
+//! is updated only after a record is completely written, so a crash of the
+//! process loses at most the record being appended. Writeback to disk is
+//! asynchronous, so a power loss may lose the most recent records; torn
+//! records are detected and skipped. When the ring is full new records are
+//! rejected.
+//!
+class Spool
+{
+public:
+    //! Constructor, opens or creates the segment file.
+    //! \param path segment file path.
+    //! \param capacity file size in bytes, an existing valid file keeps its size.
+    Spool(const std::string& path, size_t capacity);
+    //! Destructor.
+    ~Spool();
+
+    //! Appends a record.
+    //! \param data record contents.
+    //! \param size record length in bytes.
+    //! \return False if there is no room for the record.
+    bool append(const char* data, size_t size);
+    //! Gets the oldest record.
+    //! \param data set to the record contents, valid until the next pop().
+    //! \param size set to the record length in bytes.
+    //! \return False if the spool is empty.
+    bool front(const char*& data, size_t& size);
+    //! Removes the oldest record.
+    void pop();
+
+    //! Is the spool empty?
+    bool empty() const;
+    //! Gets the number of bytes used by records.
+    size_t used() const;
+    //! Gets the number of bytes available for records.
+    size_t capacity() const
+    {
+        return _dataEnd - _dataStart;
+    }
+
+private:
+    struct Header;
+
+    Spool(const Spool&);
+    Spool& operator=(const Spool&);
+
+    Header* _header() const;
+    void _reset();
+    void _commit();
+    size_t _oldest(uint32_t& length) const;
+    size_t _advance(size_t offset, uint32_t length) const;
+
+    int             _fd;            //!< Segment file.
+    char*           _map;           //!< Mapped segment.
+    size_t          _size;          //!< Size of the mapping.
+    size_t          _dataStart;     //!< Offset of the first record slot.
+    size_t          _dataEnd;       //!< Offset past the last record slot.
+};
+
+} /* namespace PowerMonitor */
+
+#endif /* SPOOL_H_ */
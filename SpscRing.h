@@ -0,0 +1,94 @@
+/*
+ * SpscRing.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SPSCRING_H_
+#define SPSCRING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace PowerMonitor
+{
+
+//! Lock-free single-producer single-consumer ring of preallocated slots.
+//!
+//! The producer fills a slot in place between acquireWrite() and
+//! commitWrite(), the consumer reads it in place between acquireRead() and
+//! releaseRead(). Slots are constructed once and reused, so nothing is
+//! allocated or copied while running. Exactly one thread may produce and
+//! one thread may consume.
+//!
+template<class T> class SpscRing
+{
+public:
+    //! Constructor.
+    //! \param capacity number of slots.
+    //! \param prototype value every slot is initialized with.
+    SpscRing(size_t capacity, const T& prototype = T()) :
+            _slots(capacity, prototype),
+            _head(0),
+            _tail(0)
+    {
+    }
+
+    //! Gets the number of slots.
+    size_t capacity() const
+    {
+        return _slots.size();
+    }
+
+    //! Gets the number of committed slots not yet released by the consumer.
+    size_t size() const
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    //! Gets the next free slot, producer only.
+    //! \return Slot to fill or nullptr if the ring is full.
+    T* acquireWrite()
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) == _slots.size())
+            return nullptr;
+        return &_slots[head % _slots.size()];
+    }
+
+    //! Publishes the slot returned by acquireWrite(), producer only.
+    void commitWrite()
+    {
+        _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    //! Gets the oldest committed slot, consumer only.
+    //! \return Slot to read or nullptr if the ring is empty.
+    T* acquireRead()
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire))
+            return nullptr;
+        return &_slots[tail % _slots.size()];
+    }
+
+    //! Returns the slot returned by acquireRead() to the producer, consumer only.
+    void releaseRead()
+    {
+        _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    SpscRing(const SpscRing&);
+    SpscRing& operator=(const SpscRing&);
+
+    std::vector<T>      _slots;     //!< Preallocated slots.
+    // Keep the indices on separate cache lines to avoid false sharing.
+    alignas(64) std::atomic<size_t> _head;  //!< Number of slots committed.
+    alignas(64) std::atomic<size_t> _tail;  //!< Number of slots released.
+};
+
+} /* namespace PowerMonitor */
+
+#endif /* SPSCRING_H_ */
@@ -0,0 +1,97 @@
+/*
+ * SyntheticSource.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include "SyntheticSource.h"
+
+namespace PowerMonitor
+{
+
+// 12-bit ADC with 5 V reference, as read from the adc1x8s102 by default.
+static const float MID_SCALE = 2048.f;
+static const float FULL_SCALE = 4095.f;
+static const float MILLIVOLTS_PER_COUNT = 5000.f / 4096.f;
+static const double PI = 3.14159265358979323846;
+
+SyntheticSource::SyntheticSource(unsigned int sampleRate, unsigned int blockSize,
+        const std::vector<Waveform>& waveforms, const Options& options) :
+        _sampleRate(sampleRate),
+        _waveforms(waveforms),
+        _options(options),
+        _theta(0.0),
+        _generated(0),
+        _limit(options.duration * sampleRate),
+        _start(0),
+        _random(2463534242u),
+        _block(waveforms.size(), blockSize)
+{
+    for (unsigned int c = 0; c < waveforms.size(); ++c)
+        _block.scale[c] = MILLIVOLTS_PER_COUNT;
+}
+
+void SyntheticSource::start()
+{
+    _start = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+const SampleBlock* SyntheticSource::next(unsigned int)
+{
+    if (finished())
+        return nullptr;
+    size_t count = _block.capacity;
+    if (_limit > 0)
+        count = std::min<unsigned long long>(count, _limit - _generated);
+    const unsigned int channels = _block.channels();
+    const double dt = 1.0 / _sampleRate;
+    for (size_t i = 0; i < count; ++i)
+    {
+        double t = (_generated + i) * dt;
+        double f = _options.frequency;
+        if (_options.drift != 0.f)
+            f += _options.drift * std::sin(2.0 * PI * t / _options.driftPeriod);
+        for (unsigned int c = 0; c < channels; ++c)
+        {
+            const Waveform& w = _waveforms[c];
+            double angle = _theta + w.phase * PI / 180.0;
+            double value = std::sin(angle);
+            for (size_t h = 0; h < w.harmonics.size(); ++h)
+                value += w.harmonics[h] * std::sin((h + 2) * angle);
+            float noise = 0.f;
+            if (_options.noise != 0.f)
+            {
+                // Xorshift, uniform in [-noise, noise].
+                _random ^= _random << 13;
+                _random ^= _random >> 17;
+                _random ^= _random << 5;
+                noise = _options.noise * (2.f * _random / 4294967295.f - 1.f);
+            }
+            float code = MID_SCALE + w.amplitude * value + noise;
+            _block.channel(c)[i] = (int16_t) std::lrint(std::min(std::max(code, 0.f), FULL_SCALE));
+        }
+        _theta += 2.0 * PI * f * dt;
+        if (_theta > 2.0 * PI)
+            _theta -= 2.0 * PI;
+    }
+    _generated += count;
+    _block.size = count;
+    // Whole seconds first, the product would overflow after 2^64 / 1e9 samples.
+    const unsigned long long last = _generated - 1;
+    _block.timestamp = _start + (long long) (last / _sampleRate) * 1000000000LL
+            + (long long) (last % _sampleRate * 1000000000ULL / _sampleRate);
+    if (_options.realtime)
+    {
+        std::chrono::nanoseconds due(_block.timestamp);
+        std::this_thread::sleep_until(std::chrono::system_clock::time_point(
+                std::chrono::duration_cast<std::chrono::system_clock::duration>(due)));
+    }
+    return &_block;
+}
+
+} /* namespace PowerMonitor */
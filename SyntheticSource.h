@@ -0,0 +1,94 @@
+/*
+ * SyntheticSource.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SYNTHETICSOURCE_H_
+#define SYNTHETICSOURCE_H_
+
+#include <cstdint>
+#include <vector>
+#include "SampleBlock.h"
+#include "SampleSource.h"
+
+namespace PowerMonitor
+{
+
+//! Generates three phase test waveforms.
+//!
+//! Produces raw 12-bit ADC codes around mid-scale, as the board would read
+//! them, so the whole pipeline is exercised without hardware. Each channel
+//! is a sine with its own amplitude, phase and harmonics. The frequency may
+//! drift sinusoidally around the nominal value. Blocks are produced as fast
+//! as the consumer takes them unless realtime is set; timestamps advance by
+//! the block duration from the time of start().
+//!
+class SyntheticSource : public SampleSource
+{
+public:
+    //! Waveform of one channel.
+    struct Waveform
+    {
+        float amplitude;                //!< Peak amplitude in ADC counts.
+        float phase;                    //!< Phase relative to the voltage in degrees.
+        std::vector<float> harmonics;   //!< Relative amplitudes of harmonics 2, 3 and so on.
+    };
+
+    //! Generator settings.
+    struct Options
+    {
+        Options() :
+                frequency(50.f),
+                drift(0.f),
+                driftPeriod(60.f),
+                noise(0.f),
+                duration(0.f),
+                realtime(false)
+        {
+        }
+
+        float frequency;        //!< Nominal frequency in Hz.
+        float drift;            //!< Peak frequency deviation in Hz.
+        float driftPeriod;      //!< Period of the frequency drift in seconds.
+        float noise;            //!< Peak uniform noise in ADC counts.
+        float duration;         //!< Seconds of signal to generate, 0 for no end.
+        bool realtime;          //!< Produce blocks at the sampling rate?
+    };
+
+    //! Constructor.
+    //! \param sampleRate sampling rate in Hz.
+    //! \param blockSize number of samples per channel in a block.
+    //! \param waveforms waveform of each channel in BlockProcessor channel order.
+    //! \param options generator settings.
+    SyntheticSource(unsigned int sampleRate, unsigned int blockSize,
+            const std::vector<Waveform>& waveforms, const Options& options = Options());
+
+    void start() override;
+    void stop() override
+    {
+    }
+    const SampleBlock* next(unsigned int timeoutMs) override;
+    void release() override
+    {
+    }
+    bool finished() const override
+    {
+        return _limit > 0 && _generated >= _limit;
+    }
+
+private:
+    unsigned int            _sampleRate;    //!< Sampling rate in Hz.
+    std::vector<Waveform>   _waveforms;     //!< Channel waveforms.
+    Options                 _options;       //!< Generator settings.
+    double                  _theta;         //!< Fundamental phase in radians.
+    unsigned long long      _generated;     //!< Samples per channel generated.
+    unsigned long long      _limit;         //!< Samples per channel to generate, 0 for no limit.
+    long long               _start;         //!< Time of start() in nanoseconds since Unix epoch.
+    uint32_t                _random;        //!< Noise generator state.
+    SampleBlock             _block;         //!< Block handed out.
+};
+
+} /* namespace PowerMonitor */
+
+#endif /* SYNTHETICSOURCE_H_ */
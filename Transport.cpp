@@ -0,0 +1,409 @@
+/*
+ * Transport.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include "Transport.h"
+
+namespace PowerMonitor
+{
+
+//! Opens a socket connected to the first usable address of a host.
+//! \param host host name or address.
+//! \param port port.
+//! \param type SOCK_DGRAM or SOCK_STREAM.
+//! \param connecting set if a non-blocking connect is still in progress.
+//! \return Socket, non-blocking for streams, or -1 on failure.
+static int openSocket(const std::string& host, const std::string& port, int type, bool& connecting)
+{
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = type;
+    struct addrinfo* addresses;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0)
+        return -1;
+    int s = -1;
+    for (struct addrinfo* a = addresses; a != nullptr && s < 0; a = a->ai_next)
+    {
+        s = socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC | (type == SOCK_STREAM ? SOCK_NONBLOCK : 0),
+                a->ai_protocol);
+        if (s < 0)
+            continue;
+        connecting = false;
+        if (connect(s, a->ai_addr, a->ai_addrlen) != 0)
+        {
+            if (errno == EINPROGRESS)
+                connecting = true;
+            else
+            {
+                close(s);
+                s = -1;
+            }
+        }
+    }
+    freeaddrinfo(addresses);
+    return s;
+}
+
+HttpTransport::HttpTransport(const std::string& url, const std::string& user, const std::string& password,
+        int gzipLevel, size_t gzipMinSize) :
+        _headers(NULL),
+        _gzipHeaders(NULL),
+        _gzipMinSize(gzipMinSize)
+{
+    if (gzipLevel != 0)
+        _gzip.reset(new GzipEncoder(gzipLevel));
+    CURLcode ret;
+    ret = curl_global_init(CURL_GLOBAL_ALL);
+    if (ret)
+    {
+        throw std::runtime_error("Could not initialize curl: "
+                + std::string(curl_easy_strerror(ret)));
+    }
+    _handle = curl_easy_init();
+    if (!_handle)
+    {
+        curl_global_cleanup();
+        throw std::runtime_error("Unable to obtain curl handle.");
+    }
+    _multihandle = curl_multi_init();
+    if (!_multihandle)
+    {
+        curl_easy_cleanup(_handle);
+        curl_global_cleanup();
+        throw std::runtime_error("Unable to obtain curl multi handle.");
+    }
+
+    curl_easy_setopt(_handle, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(_handle, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
+    curl_easy_setopt(_handle, CURLOPT_USERNAME, user.c_str());
+    curl_easy_setopt(_handle, CURLOPT_PASSWORD, password.c_str());
+    curl_easy_setopt(_handle, CURLOPT_NOSIGNAL, 1L);
+    // Do not let a hung server keep a batch in flight forever.
+    curl_easy_setopt(_handle, CURLOPT_TIMEOUT_MS, 30000L);
+    _headers = curl_slist_append(_headers, "Expect:");
+    _gzipHeaders = curl_slist_append(_gzipHeaders, "Expect:");
+    _gzipHeaders = curl_slist_append(_gzipHeaders, "Content-Encoding: gzip");
+    curl_easy_setopt(_handle, CURLOPT_HTTPHEADER, _headers);
+}
+
+HttpTransport::~HttpTransport()
+{
+    curl_multi_remove_handle(_multihandle, _handle);
+    curl_easy_cleanup(_handle);
+    curl_multi_cleanup(_multihandle);
+    curl_slist_free_all(_headers);
+    curl_slist_free_all(_gzipHeaders);
+    curl_global_cleanup();
+}
+
+void HttpTransport::start(const std::string& payload)
+{
+    // The payload, or the encoder output, stays untouched until the
+    // transfer is done, no copy needed.
+    const std::string* body = &payload;
+    if (_gzip && payload.size() >= _gzipMinSize)
+        body = &_gzip->compress(payload.data(), payload.size());
+    curl_easy_setopt(_handle, CURLOPT_HTTPHEADER, body != &payload ? _gzipHeaders : _headers);
+    curl_easy_setopt(_handle, CURLOPT_POSTFIELDSIZE, (long) body->size());
+    curl_easy_setopt(_handle, CURLOPT_POSTFIELDS, body->data());
+    curl_multi_add_handle(_multihandle, _handle);
+}
+
+Transport::Status HttpTransport::poll(int timeoutMs)
+{
+    int running = 0;
+    curl_multi_wait(_multihandle, NULL, 0, timeoutMs, NULL);
+    curl_multi_perform(_multihandle, &running);
+    CURLMsg* msg;
+    int left;
+    while ((msg = curl_multi_info_read(_multihandle, &left)))
+    {
+        if (msg->msg != CURLMSG_DONE)
+            continue;
+        long status = 0;
+        curl_easy_getinfo(_handle, CURLINFO_RESPONSE_CODE, &status);
+        bool ok = msg->data.result == CURLE_OK && status / 100 == 2;
+        curl_multi_remove_handle(_multihandle, _handle);
+        return ok ? Sent : Failed;
+    }
+    return InFlight;
+}
+
+UdpTransport::UdpTransport(const std::string& host, const std::string& port, size_t datagramSize) :
+        _datagramSize(datagramSize),
+        _status(Failed)
+{
+    if (_datagramSize == 0)
+        throw std::invalid_argument("UDP datagram size must be positive.");
+    bool connecting;
+    _socket = openSocket(host, port, SOCK_DGRAM, connecting);
+    if (_socket < 0)
+        throw std::runtime_error("Could not open UDP socket to " + host + ":" + port + ".");
+}
+
+UdpTransport::~UdpTransport()
+{
+    close(_socket);
+}
+
+void UdpTransport::start(const std::string& payload)
+{
+    const char* data = payload.data();
+    const size_t size = payload.size();
+    size_t begin = 0;
+    _status = Sent;
+    while (begin < size)
+    {
+        // As many whole lines as fit, at least one.
+        size_t end = begin;
+        while (end < size)
+        {
+            const char* eol = (const char*) memchr(data + end, '\n', size - end);
+            size_t next = eol != nullptr ? eol - data + 1 : size;
+            if (next - begin > _datagramSize && end > begin)
+                break;
+            end = next;
+        }
+        ssize_t n;
+        do
+            n = send(_socket, data + begin, end - begin, 0);
+        while (n < 0 && errno == EINTR);
+        if (n < 0)
+        {
+            // Resent as a whole, see the class documentation.
+            _status = Failed;
+            return;
+        }
+        begin = end;
+    }
+}
+
+Transport::Status UdpTransport::poll(int)
+{
+    return _status;
+}
+
+FrameTransport::FrameTransport(const std::string& host, const std::string& port, const std::string& retentionPolicy) :
+        _host(host),
+        _port(port),
+        _socket(-1),
+        _connecting(false),
+        _payload(nullptr),
+        _written(0)
+{
+    if (retentionPolicy.size() > 255)
+        throw std::invalid_argument("Retention policy name too long for frames.");
+    _header.assign(6, '\0');
+    _header[4] = VERSION;
+    _header[5] = (char) retentionPolicy.size();
+    _header += retentionPolicy;
+}
+
+FrameTransport::FrameTransport(const std::string& path, const std::string& retentionPolicy) :
+        FrameTransport(path, "", retentionPolicy)
+{
+    if (path.size() >= sizeof(((struct sockaddr_un*) 0)->sun_path))
+        throw std::invalid_argument("Unix socket path too long: " + path);
+}
+
+FrameTransport::~FrameTransport()
+{
+    _close();
+}
+
+void FrameTransport::_connect()
+{
+    if (!_port.empty())
+    {
+        _socket = openSocket(_host, _port, SOCK_STREAM, _connecting);
+        return;
+    }
+    _socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (_socket < 0)
+        return;
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, _host.c_str(), sizeof(address.sun_path) - 1);
+    _connecting = false;
+    if (connect(_socket, (struct sockaddr*) &address, sizeof(address)) != 0)
+    {
+        if (errno == EINPROGRESS)
+            _connecting = true;
+        else
+            _close();
+    }
+}
+
+void FrameTransport::_close()
+{
+    if (_socket >= 0)
+        close(_socket);
+    _socket = -1;
+    _connecting = false;
+}
+
+Transport::Status FrameTransport::_fail()
+{
+    _close();
+    _payload = nullptr;
+    return Failed;
+}
+
+void FrameTransport::start(const std::string& payload)
+{
+    // A collector never sends, so anything readable means it has closed.
+    char c;
+    if (_socket >= 0 && !_connecting && recv(_socket, &c, 1, MSG_PEEK | MSG_DONTWAIT) >= 0)
+        _close();
+    if (_socket < 0)
+        _connect();
+    uint32_t length = _header.size() - 4 + payload.size();
+    for (int i = 0; i < 4; ++i)
+        _header[i] = (char) (length >> (24 - 8 * i));
+    _payload = &payload;
+    _written = 0;
+    _deadline = Clock::now() + std::chrono::seconds(30);
+}
+
+Transport::Status FrameTransport::poll(int timeoutMs)
+{
+    if (_payload == nullptr)
+        return Failed;
+    if (_socket < 0)
+        return _fail();
+    const Clock::time_point until = std::min(Clock::now() + std::chrono::milliseconds(timeoutMs), _deadline);
+    const size_t total = _header.size() + _payload->size();
+    for (;;)
+    {
+        while (!_connecting && _written < total)
+        {
+            struct iovec parts[2];
+            size_t n = 0;
+            if (_written < _header.size())
+            {
+                parts[n].iov_base = (void*) (_header.data() + _written);
+                parts[n++].iov_len = _header.size() - _written;
+            }
+            const size_t offset = _written > _header.size() ? _written - _header.size() : 0;
+            parts[n].iov_base = (void*) (_payload->data() + offset);
+            parts[n++].iov_len = _payload->size() - offset;
+            struct msghdr message;
+            memset(&message, 0, sizeof(message));
+            message.msg_iov = parts;
+            message.msg_iovlen = n;
+            ssize_t sent = sendmsg(_socket, &message, MSG_NOSIGNAL);
+            if (sent < 0)
+            {
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    break;
+                if (errno == EINTR)
+                    continue;
+                return _fail();
+            }
+            _written += sent;
+        }
+        if (_written == total)
+        {
+            _payload = nullptr;
+            return Sent;
+        }
+
+        const Clock::time_point now = Clock::now();
+        if (now >= _deadline)
+            return _fail();
+        if (now >= until)
+            return InFlight;
+        struct pollfd p = { _socket, POLLOUT, 0 };
+        int wait = std::chrono::duration_cast<std::chrono::milliseconds>(until - now).count() + 1;
+        if (::poll(&p, 1, wait) < 0 && errno != EINTR)
+            return _fail();
+        if (p.revents & (POLLERR | POLLHUP | POLLNVAL))
+            return _fail();
+        if (_connecting && (p.revents & POLLOUT))
+        {
+            int error = 0;
+            socklen_t size = sizeof(error);
+            if (getsockopt(_socket, SOL_SOCKET, SO_ERROR, &error, &size) != 0 || error != 0)
+                return _fail();
+            _connecting = false;
+        }
+    }
+}
+
+//! Splits "host:port" or "[address]:port".
+static void splitAddress(const std::string& url, const std::string& address, std::string& host, std::string& port)
+{
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos || colon + 1 == address.size())
+        throw std::runtime_error("Missing port in " + url + ".");
+    host = address.substr(0, colon);
+    port = address.substr(colon + 1);
+    if (host.size() >= 2 && host.front() == '[' && host.back() == ']')
+        host = host.substr(1, host.size() - 2);
+}
+
+//! URL-encodes a query parameter value.
+static std::string escape(const std::string& value)
+{
+    CURL* curl = curl_easy_init();
+    char* escaped = curl ? curl_easy_escape(curl, value.data(), value.size()) : nullptr;
+    if (curl)
+        curl_easy_cleanup(curl);
+    if (!escaped)
+        throw std::runtime_error("Failed to escape " + value + ".");
+    std::string result(escaped);
+    curl_free(escaped);
+    return result;
+}
+
+std::unique_ptr<Transport> createTransport(const std::string& host, const std::string& db, const std::string& user,
+        const std::string& password, const std::string& retentionPolicy, size_t datagramSize,
+        int gzipLevel, size_t gzipMinSize)
+{
+    std::string name, port;
+    if (host.compare(0, 6, "udp://") == 0)
+    {
+        if (!retentionPolicy.empty())
+            throw std::runtime_error("Retention policies are not supported over UDP.");
+        splitAddress(host, host.substr(6), name, port);
+        return std::unique_ptr<Transport>(new UdpTransport(name, port, datagramSize));
+    }
+    if (host.compare(0, 6, "tcp://") == 0)
+    {
+        splitAddress(host, host.substr(6), name, port);
+        return std::unique_ptr<Transport>(new FrameTransport(name, port, retentionPolicy));
+    }
+    if (host.compare(0, 5, "unix:") == 0)
+    {
+        // Both unix:/path and unix:///path.
+        std::string path = host.substr(5);
+        if (path.compare(0, 2, "//") == 0)
+            path = path.substr(2);
+        return std::unique_ptr<Transport>(new FrameTransport(path, retentionPolicy));
+    }
+
+    std::stringstream url;
+    url << host << "/write?db=" << escape(db);
+    if (!retentionPolicy.empty())
+        url << "&rp=" << escape(retentionPolicy);
+    return std::unique_ptr<Transport>(new HttpTransport(url.str(), user, password, gzipLevel, gzipMinSize));
+}
+
+} /* namespace PowerMonitor */
@@ -0,0 +1,188 @@
+/*
+ * Transport.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef TRANSPORT_H_
+#define TRANSPORT_H_
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <curl/curl.h>
+#include "Gzip.h"
+
+namespace PowerMonitor
+{
+
+//! Carries batches of line protocol to InfluxDB or a collector.
+//!
+//! A transport has at most one write in flight. start() begins the write,
+//! poll() drives it without blocking for longer than the given timeout,
+//! so the writer thread can keep batching in between. The payload must
+//! stay untouched until poll() reports the write as done.
+//!
+class Transport
+{
+public:
+    //! State of the write in flight.
+    enum Status
+    {
+        InFlight,       //!< Not done yet.
+        Sent,           //!< Written successfully.
+        Failed          //!< Not written, the batch may be retried.
+    };
+
+    virtual ~Transport()
+    {
+    }
+
+    //! Starts writing a batch.
+    //! \param payload complete lines, each terminated by a newline.
+    virtual void start(const std::string& payload) = 0;
+
+    //! Drives the write in flight.
+    //! \param timeoutMs maximum time to wait for progress in ms.
+    //! \return State of the write.
+    virtual Status poll(int timeoutMs) = 0;
+};
+
+//! InfluxDB HTTP API, with basic authentication and a reused connection.
+//!
+//! Batches from the given size on can be sent with Content-Encoding gzip.
+//! Smaller ones gain little and are sent as they are.
+//!
+class HttpTransport : public Transport
+{
+public:
+    //! Constructor.
+    //! \param url write URL including database and retention policy.
+    //! \param user user name.
+    //! \param password password.
+    //! \param gzipLevel compression level from 1 to 9, 0 to send uncompressed.
+    //! \param gzipMinSize smallest batch to compress in bytes.
+    HttpTransport(const std::string& url, const std::string& user, const std::string& password,
+            int gzipLevel = 0, size_t gzipMinSize = 0);
+    ~HttpTransport() override;
+
+    void start(const std::string& payload) override;
+    Status poll(int timeoutMs) override;
+
+private:
+    HttpTransport(const HttpTransport&);
+    HttpTransport& operator=(const HttpTransport&);
+
+    CURLM*                          _multihandle;
+    CURL*                           _handle;
+    struct curl_slist*              _headers;
+    struct curl_slist*              _gzipHeaders;   //!< Headers of a compressed batch.
+    std::unique_ptr<GzipEncoder>    _gzip;          //!< Encoder, none if not compressing.
+    size_t                          _gzipMinSize;   //!< Smallest batch to compress.
+};
+
+//! InfluxDB UDP listener.
+//!
+//! Lines are packed into datagrams of at most the given size, splitting
+//! only between lines; a longer line goes out alone. There is no reply,
+//! so a write only fails if the datagrams cannot be sent, e.g. after an
+//! ICMP port unreachable reported by the kernel.
+//!
+//! A failed write is retried as a whole, so the datagrams sent before the
+//! failure may arrive twice. That is deliberate: the kernel reports an
+//! ICMP error on the send after the refused datagram, so the earlier ones
+//! cannot be known to have arrived. InfluxDB keeps one point per series
+//! and timestamp, and a duplicate overwrites it with the same values.
+//!
+class UdpTransport : public Transport
+{
+public:
+    //! Constructor.
+    //! \param host host name or address.
+    //! \param port UDP port.
+    //! \param datagramSize maximum payload per datagram in bytes.
+    UdpTransport(const std::string& host, const std::string& port, size_t datagramSize);
+    ~UdpTransport() override;
+
+    void start(const std::string& payload) override;
+    Status poll(int timeoutMs) override;
+
+private:
+    UdpTransport(const UdpTransport&);
+    UdpTransport& operator=(const UdpTransport&);
+
+    int                 _socket;
+    size_t              _datagramSize;  //!< Maximum payload per datagram.
+    Status              _status;        //!< Result of the last start().
+};
+
+//! Length-prefixed frames over a TCP or Unix stream socket.
+//!
+//! Each batch is one frame: a 32 bit big-endian length of the rest of the
+//! frame, a version byte (1), the length and name of the retention
+//! policy, then the lines unchanged. A collector can forward the lines to
+//! InfluxDB as they are. The connection is kept open, a broken one is
+//! reopened with the next batch. A write counts as sent once the frame is
+//! in the socket buffer.
+//!
+class FrameTransport : public Transport
+{
+public:
+    //! Frame format version.
+    static const unsigned char VERSION = 1;
+
+    //! Constructor, for TCP.
+    //! \param host host name or address.
+    //! \param port TCP port.
+    //! \param retentionPolicy retention policy passed in every frame.
+    FrameTransport(const std::string& host, const std::string& port, const std::string& retentionPolicy);
+    //! Constructor, for a Unix socket.
+    //! \param path socket path.
+    //! \param retentionPolicy retention policy passed in every frame.
+    FrameTransport(const std::string& path, const std::string& retentionPolicy);
+    ~FrameTransport() override;
+
+    void start(const std::string& payload) override;
+    Status poll(int timeoutMs) override;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    FrameTransport(const FrameTransport&);
+    FrameTransport& operator=(const FrameTransport&);
+
+    void _connect();
+    void _close();
+    Status _fail();
+
+    std::string         _host;          //!< Host name, or the path of a Unix socket.
+    std::string         _port;          //!< Port, empty for a Unix socket.
+    int                 _socket;
+    bool                _connecting;    //!< Non-blocking connect in progress?
+    std::string         _header;        //!< Header of the frame in flight.
+    const std::string*  _payload;       //!< Lines of the frame in flight.
+    size_t              _written;       //!< Bytes of the frame written so far.
+    Clock::time_point   _deadline;      //!< Give up on the frame after this.
+};
+
+//! Creates the transport for a host URL.
+//!
+//! "udp://host:port" selects the InfluxDB UDP listener, "tcp://host:port"
+//! and "unix:/path" frames to a collector, anything else the HTTP API.
+//! \param host host URL.
+//! \param db database, HTTP only.
+//! \param user user name, HTTP only.
+//! \param password password, HTTP only.
+//! \param retentionPolicy retention policy, empty for the default; not
+//! supported over UDP, where the listener's configuration applies.
+//! \param datagramSize maximum UDP payload in bytes.
+//! \param gzipLevel HTTP compression level from 1 to 9, 0 for none.
+//! \param gzipMinSize smallest batch to compress over HTTP in bytes.
+//! \return Transport.
+std::unique_ptr<Transport> createTransport(const std::string& host, const std::string& db, const std::string& user,
+        const std::string& password, const std::string& retentionPolicy, size_t datagramSize,
+        int gzipLevel, size_t gzipMinSize);
+
+} /* namespace PowerMonitor */
+
+#endif /* TRANSPORT_H_ */
@@ -0,0 +1,209 @@
+/*
+ * WaveformStream.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "WaveformStream.h"
+
+namespace PowerMonitor
+{
+
+namespace
+{
+
+const char waveformMagic[8] = { 'P', 'M', 'W', 'A', 'V', 'E', '0', '1' };
+
+// Slots start on their own cache lines.
+const size_t slotAlignment = 64;
+
+// Readers in other processes can only rely on lock-free atomics.
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Waveform streams need lock-free 64-bit atomics.");
+
+inline size_t aligned(size_t size)
+{
+    return (size + slotAlignment - 1) & ~(slotAlignment - 1);
+}
+
+}
+
+WaveformPublisher::WaveformPublisher(const std::string& name, const std::vector<std::string>& names,
+        unsigned int sampleRate, unsigned int capacity, unsigned int slots) :
+        _name(name),
+        _size(0),
+        _header(nullptr),
+        _slot(nullptr),
+        _samples(nullptr),
+        _count(0)
+{
+    if (names.empty() || names.size() > WaveformHeader::MAX_CHANNELS)
+        throw std::runtime_error("Waveform stream needs 1 to 16 channels.");
+    if (slots < 2 || capacity == 0)
+        throw std::runtime_error("Waveform stream needs at least two slots.");
+    const size_t slotOffset = aligned(sizeof(WaveformHeader));
+    const size_t slotSize = aligned(sizeof(WaveformSlot) + names.size() * capacity * sizeof(float));
+    _size = slotOffset + slots * slotSize;
+
+    // Start from a fresh object so that readers of a previous run see it closed.
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0)
+        throw std::runtime_error("Could not create shared memory " + name + ": " + std::string(strerror(errno)));
+    void* map = MAP_FAILED;
+    if (ftruncate(fd, _size) == 0)
+        map = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int error = errno;
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Could not map shared memory " + name + ": " + std::string(strerror(error)));
+    }
+
+    // The object is zero filled, so no slot holds a valid block yet.
+    _header = (WaveformHeader*) map;
+    _header->channels = names.size();
+    _header->sampleRate = sampleRate;
+    _header->capacity = capacity;
+    _header->slots = slots;
+    _header->slotOffset = slotOffset;
+    _header->slotSize = slotSize;
+    for (size_t c = 0; c < names.size(); ++c)
+        strncpy(_header->names[c], names[c].c_str(), WaveformHeader::NAME_SIZE - 1);
+    _header->sequence.store(0, std::memory_order_relaxed);
+    _header->closed.store(0, std::memory_order_relaxed);
+    // Readers check the magic last.
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(_header->magic, waveformMagic, sizeof(waveformMagic));
+}
+
+WaveformPublisher::~WaveformPublisher()
+{
+    _header->closed.store(1, std::memory_order_release);
+    munmap(_header, _size);
+    shm_unlink(_name.c_str());
+}
+
+void WaveformPublisher::begin(long long timestamp, size_t count)
+{
+    uint64_t block = _header->sequence.load(std::memory_order_relaxed);
+    char* slot = (char*) _header + _header->slotOffset + (block % _header->slots) * _header->slotSize;
+    _slot = (WaveformSlot*) slot;
+    _samples = (float*) (slot + sizeof(WaveformSlot));
+    _count = std::min<size_t>(count, _header->capacity);
+    // Mark the slot as being written before touching the samples.
+    _slot->state.store(2 * block + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _slot->timestamp = timestamp;
+    _slot->count = _count;
+}
+
+void WaveformPublisher::commit()
+{
+    uint64_t block = _header->sequence.load(std::memory_order_relaxed);
+    _slot->state.store(2 * block + 2, std::memory_order_release);
+    _header->sequence.store(block + 1, std::memory_order_release);
+}
+
+WaveformSubscriber::WaveformSubscriber(const std::string& name, bool latest) :
+        _size(0),
+        _header(nullptr),
+        _next(0),
+        _lost(0)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0)
+        throw std::runtime_error("Could not open shared memory " + name + ": " + std::string(strerror(errno)));
+    struct stat st;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t) st.st_size >= sizeof(WaveformHeader))
+    {
+        _size = st.st_size;
+        map = mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED)
+        throw std::runtime_error("Could not map shared memory " + name + ".");
+    _header = (const WaveformHeader*) map;
+    bool ok = memcmp(_header->magic, waveformMagic, sizeof(waveformMagic)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    ok = ok && _header->channels > 0 && _header->channels <= WaveformHeader::MAX_CHANNELS
+            && _header->slots >= 2
+            && _header->slotSize >= sizeof(WaveformSlot) + _header->channels * _header->capacity * sizeof(float)
+            && _header->slotOffset + (size_t) _header->slots * _header->slotSize <= _size;
+    if (!ok)
+    {
+        munmap((void*) _header, _size);
+        throw std::runtime_error("Not a waveform stream: " + name);
+    }
+    uint64_t sequence = _header->sequence.load(std::memory_order_acquire);
+    if (latest)
+        _next = sequence > 0 ? sequence - 1 : 0;
+    else
+        _next = sequence >= _header->slots ? sequence - _header->slots + 1 : 0;
+}
+
+WaveformSubscriber::~WaveformSubscriber()
+{
+    munmap((void*) _header, _size);
+}
+
+const WaveformSlot* WaveformSubscriber::_slotOf(uint64_t block) const
+{
+    return (const WaveformSlot*) ((const char*) _header + _header->slotOffset
+            + (block % _header->slots) * _header->slotSize);
+}
+
+WaveformSubscriber::Status WaveformSubscriber::next(View& view)
+{
+    Status status = Ready;
+    for (;;)
+    {
+        uint64_t sequence = _header->sequence.load(std::memory_order_acquire);
+        if (_next >= sequence)
+            return Empty;
+        // The writer may already be overwriting the slot of block sequence - slots.
+        uint64_t oldest = sequence >= _header->slots ? sequence - _header->slots + 1 : 0;
+        if (_next < oldest)
+        {
+            _lost += oldest - _next;
+            _next = oldest;
+            status = Overrun;
+        }
+        const WaveformSlot* slot = _slotOf(_next);
+        if (slot->state.load(std::memory_order_acquire) != 2 * _next + 2)
+        {
+            // Lapped since the sequence was read, try again from the new position.
+            continue;
+        }
+        view.block = _next;
+        view.timestamp = slot->timestamp;
+        view.count = slot->count;
+        view.samples = (const float*) ((const char*) slot + sizeof(WaveformSlot));
+        view.capacity = _header->capacity;
+        ++_next;
+        return status;
+    }
+}
+
+bool WaveformSubscriber::valid(const View& view) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return _slotOf(view.block)->state.load(std::memory_order_relaxed) == 2 * view.block + 2;
+}
+
+std::string WaveformSubscriber::name(unsigned int channel) const
+{
+    const char* name = _header->names[channel];
+    return std::string(name, strnlen(name, WaveformHeader::NAME_SIZE));
+}
+
+} /* namespace PowerMonitor */
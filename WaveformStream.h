@@ -0,0 +1,199 @@
+/*
+ * WaveformStream.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef WAVEFORMSTREAM_H_
+#define WAVEFORMSTREAM_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace PowerMonitor
+{
+
+//! Layout of the POSIX shared memory object of a waveform stream.
+//!
+//! The object starts with this header, followed by the slots at multiples
+//! of slotSize from slotOffset. Block n of the stream is in slot n % slots.
+//! A slot holds a WaveformSlot header and the samples in volts or amperes,
+//! capacity floats per channel, one channel after another. The counters
+//! are lock-free atomics, so they work across processes.
+//!
+struct WaveformHeader
+{
+    static const unsigned int MAX_CHANNELS = 16;
+    static const unsigned int NAME_SIZE = 16;
+
+    char                    magic[8];                           //!< "PMWAVE01".
+    uint32_t                channels;                           //!< Number of channels.
+    uint32_t                sampleRate;                         //!< Sampling rate in Hz.
+    uint32_t                capacity;                           //!< Maximum samples per channel in a block.
+    uint32_t                slots;                              //!< Number of slots.
+    uint32_t                slotOffset;                         //!< Offset of the first slot in bytes.
+    uint32_t                slotSize;                           //!< Size of a slot in bytes.
+    std::atomic<uint64_t>   sequence;                           //!< Number of blocks published.
+    std::atomic<uint32_t>   closed;                             //!< Set when the writer exits.
+    uint32_t                reserved;
+    char                    names[MAX_CHANNELS][NAME_SIZE];     //!< Zero terminated channel names.
+};
+
+//! Header of one slot of a waveform stream.
+struct WaveformSlot
+{
+    std::atomic<uint64_t>   state;          //!< 2n + 1 while block n is written, 2n + 2 when done.
+    int64_t                 timestamp;      //!< Time of the last sample in nanoseconds since Unix epoch.
+    uint32_t                count;          //!< Samples per channel.
+    uint32_t                reserved;
+};
+
+//! Publishes filtered waveforms into a shared memory ring.
+//!
+//! The writer never waits for readers: each block overwrites the oldest
+//! slot, and readers that fall behind detect it, see WaveformSubscriber.
+//! The object is removed when the publisher is destroyed.
+//!
+class WaveformPublisher
+{
+public:
+    //! Constructor, creates the shared memory object.
+    //! \param name shared memory object name, e.g. "/powermon".
+    //! \param names channel names.
+    //! \param sampleRate sampling rate in Hz.
+    //! \param capacity maximum number of samples per channel in a block.
+    //! \param slots number of blocks kept.
+    WaveformPublisher(const std::string& name, const std::vector<std::string>& names,
+            unsigned int sampleRate, unsigned int capacity, unsigned int slots);
+    //! Destructor, marks the stream closed and removes the object.
+    ~WaveformPublisher();
+
+    //! Starts writing the next block into its slot.
+    //! \param timestamp time of the last sample in nanoseconds since Unix epoch.
+    //! \param count number of samples per channel, at most the capacity.
+    void begin(long long timestamp, size_t count);
+
+    //! Stores the samples of a channel of the block started by begin().
+    //! \param channel channel index.
+    //! \param samples count samples.
+    //! \param scale factor from the samples to volts or amperes.
+    template<class T> void write(unsigned int channel, const T* samples, double scale = 1.0)
+    {
+        float* out = _samples + channel * _header->capacity;
+        const float s = scale;
+        for (size_t i = 0; i < _count; ++i)
+            out[i] = samples[i] * s;
+    }
+
+    //! Makes the block started by begin() visible to readers.
+    void commit();
+
+private:
+    WaveformPublisher(const WaveformPublisher&);
+    WaveformPublisher& operator=(const WaveformPublisher&);
+
+    std::string         _name;          //!< Shared memory object name.
+    size_t              _size;          //!< Size of the mapping.
+    WaveformHeader*     _header;        //!< Mapped object.
+    WaveformSlot*       _slot;          //!< Slot being written.
+    float*              _samples;       //!< Samples of the slot being written.
+    size_t              _count;         //!< Samples per channel being written.
+};
+
+//! Reads a waveform stream published by powermon.
+//!
+//! Reading needs no system calls and no copies: next() returns a view
+//! into the shared memory. Since the writer never waits, a view can be
+//! overwritten while it is used, so check it with valid() after use.
+//! A reader more than the ring behind skips to the oldest block still
+//! kept and reports an overrun.
+//!
+//! Link WaveformStream.cpp into the client to use it.
+//!
+class WaveformSubscriber
+{
+public:
+    //! Result of next().
+    enum Status
+    {
+        Ready,      //!< A new block is available.
+        Empty,      //!< No new block yet.
+        Overrun     //!< Blocks were lost, the view holds the oldest kept block.
+    };
+
+    //! A block in the shared memory.
+    struct View
+    {
+        uint64_t        block;          //!< Block number.
+        long long       timestamp;      //!< Time of the last sample in nanoseconds since Unix epoch.
+        size_t          count;          //!< Samples per channel.
+        const float*    samples;        //!< First channel.
+        size_t          capacity;       //!< Distance between channels.
+
+        //! Gets the samples of a channel in volts or amperes.
+        const float* channel(unsigned int c) const
+        {
+            return samples + c * capacity;
+        }
+    };
+
+    //! Constructor, maps the shared memory object read only.
+    //! \param name shared memory object name.
+    //! \param latest start from the latest block instead of the oldest kept.
+    WaveformSubscriber(const std::string& name, bool latest = true);
+    //! Destructor, unmaps the object.
+    ~WaveformSubscriber();
+
+    //! Gets the next block.
+    //! \param view set to the block on Ready and Overrun.
+    //! \return Status, see Status.
+    Status next(View& view);
+
+    //! Checks that a view was not overwritten while it was used.
+    bool valid(const View& view) const;
+
+    //! Gets the number of blocks lost to overruns.
+    unsigned long long lost() const
+    {
+        return _lost;
+    }
+
+    //! Checks whether the writer has exited. Reopen to follow a new one.
+    bool closed() const
+    {
+        return _header->closed.load(std::memory_order_acquire) != 0;
+    }
+
+    unsigned int channels() const
+    {
+        return _header->channels;
+    }
+    unsigned int sampleRate() const
+    {
+        return _header->sampleRate;
+    }
+    unsigned int capacity() const
+    {
+        return _header->capacity;
+    }
+    //! Gets the name of a channel.
+    std::string name(unsigned int channel) const;
+
+private:
+    WaveformSubscriber(const WaveformSubscriber&);
+    WaveformSubscriber& operator=(const WaveformSubscriber&);
+
+    const WaveformSlot* _slotOf(uint64_t block) const;
+
+    size_t                  _size;          //!< Size of the mapping.
+    const WaveformHeader*   _header;        //!< Mapped object.
+    uint64_t                _next;          //!< Next block to read.
+    unsigned long long      _lost;          //!< Blocks lost to overruns.
+};
+
+} /* namespace PowerMonitor */
+
+#endif /* WAVEFORMSTREAM_H_ */
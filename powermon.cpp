@@ -1,28 +1,41 @@
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <csignal>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
 #include <vector>
+#include <getopt.h>
+#include "Acquisition.h"
 #include "Adc.h"
+#include "BlockProcessor.h"
+#include "Capture.h"
+#include "Circuit.h"
 #include "Configuration.h"
-#include "Delay.h"
-#include "HighPassFilter.h"
+#include "Deadband.h"
+#include "EventDetector.h"
+#include "Harmonics.h"
 #include "InfluxdbWriter.h"
-#include "Meter.h"
-
-#define BURDEN_RESISTANCE 99.5f // Ohms
-#define VOLTAGE_DIVIDER_RATIO 0.138268156f // 9.9 / (61.7 + 9.9)
-#define CURRENT_TRANSFORMER_RATIO 0.0005f // 50 mA / 100 A
-#define TRANSFORMER_RATIO (0.048869565f * 0.9657f) // 11.24 V / 230 V * calibration factor
-
-// Channel mappings.
-#define L1 1
-#define L2 3
-#define L3 0
-#define V 4
-#define N 2
+#include "LineProtocol.h"
+#include "Metrics.h"
+#include "ReadingServer.h"
+#include "Relay.h"
+#include "Rollup.h"
+#include "SyntheticSource.h"
+#include "WaveformStream.h"
 
 using namespace PowerMonitor;
 
+// Sample type of the processing pipeline.
+#ifdef POWERMON_FIXED_POINT
+typedef BlockProcessor<int32_t> Processor;
+#else
+typedef BlockProcessor<float> Processor;
+#endif
+
 volatile sig_atomic_t terminate = 0;
 
 static void sighandler(int signum)
@@ -30,16 +43,79 @@ static void sighandler(int signum)
     terminate = 1;
 }
 
-float voltageToVoltage(float v)
+static void usage(const char* name)
 {
-    // Millivolts from ADC to mains voltage in volts.
-    return v / 1000.f / VOLTAGE_DIVIDER_RATIO / TRANSFORMER_RATIO;
+    std::cerr << "Usage: " << name << " [--capture FILE] [--replay FILE | --synthetic]\n"
+            << "       " << name << " --relay\n"
+            << "  --capture FILE  write the raw sample blocks to FILE\n"
+            << "  --replay FILE   process a capture file as fast as possible instead of the ADC\n"
+            << "  --synthetic     process generated waveforms instead of the ADC\n"
+            << "  --relay         forward the writes of other meters to InfluxDB\n";
 }
 
-float voltageToCurrent(float v)
+//! Runs as a relay for other meters until terminated, see Relay.
+static void runRelay(Configuration& conf, const InfluxdbWriter::Options& options)
 {
-    // Millivolts from ADC to mains current in amperes.
-    return v / 1000.f / BURDEN_RESISTANCE / CURRENT_TRANSFORMER_RATIO;
+    const std::string host = conf.get<std::string>("PowerMonitor.InfluxDB.host");
+    const std::string database = conf.get<std::string>("PowerMonitor.InfluxDB.database");
+    const std::string username = conf.get<std::string>("PowerMonitor.InfluxDB.username");
+    const std::string password = conf.get<std::string>("PowerMonitor.InfluxDB.password");
+    Relay relay(readRelayOptions(conf), [&](const std::string& retention)
+    {
+        InfluxdbWriter::Options writer_options = options;
+        writer_options.retentionPolicy = retention;
+        if (!retention.empty() && !writer_options.spoolPath.empty())
+            writer_options.spoolPath += "." + retention;
+        return std::unique_ptr<InfluxdbWriter>(
+                new InfluxdbWriter(host, database, username, password, writer_options));
+    });
+
+    // Per-source statistics, also written to InfluxDB unless turned off.
+    const std::chrono::seconds interval(conf.get("PowerMonitor.relay.statsinterval", 10));
+    const bool write_stats = conf.get("PowerMonitor.relay.writestats", true);
+    InfluxdbWriter& influx = relay.writer("");
+    LineProtocol lines;
+    auto next = std::chrono::steady_clock::now() + interval;
+    while (!terminate)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (std::chrono::steady_clock::now() < next)
+            continue;
+        next += interval;
+        lines.clear();
+        relay.writeStats(lines, std::chrono::system_clock::now().time_since_epoch().count());
+        std::cout.write(lines.data(), lines.size());
+        std::cout << influx.queued() << " lines queued, " << influx.dropped() << " dropped, "
+                << influx.failures() << " failed writes, " << influx.spooled() << " bytes spooled" << std::endl;
+        if (write_stats)
+            influx.write(lines);
+    }
+}
+
+//! Generated waveforms for --synthetic, from PowerMonitor.synthetic.
+static std::vector<SyntheticSource::Waveform> syntheticWaveforms(Configuration& conf,
+        const std::vector<Circuit>& circuits)
+{
+    std::vector<SyntheticSource::Waveform> waveforms;
+    for (auto&& item : conf.getObjects("PowerMonitor.synthetic.channels"))
+    {
+        SyntheticSource::Waveform w;
+        w.amplitude = item.get("amplitude", 1000.f);
+        w.phase = item.get("phase", 0.f);
+        if (item.has("harmonics"))
+            w.harmonics = item.getArray<float>("harmonics");
+        waveforms.push_back(w);
+    }
+    // By default a 230 V voltage and currents lagging their phase by 20 degrees.
+    for (size_t c = waveforms.size(); c < circuits.size(); ++c)
+    {
+        SyntheticSource::Waveform w;
+        w.amplitude = c == 0 ? 1500.f : 300.f * c;
+        w.phase = c == 0 ? 0.f : -120.f * (circuits[c].phase - 1) - 20.f;
+        waveforms.push_back(w);
+    }
+    waveforms.resize(circuits.size());
+    return waveforms;
 }
 
 int main(int argc, char **argv)
@@ -55,90 +131,423 @@ int main(int argc, char **argv)
     sigaction(SIGINT, &sa, NULL);
     sigaction(SIGTERM, &sa, NULL);
 
+    std::string capture_path, replay_path;
+    bool synthetic = false;
+    bool relay = false;
+    static const struct option long_options[] = {
+        { "capture", required_argument, nullptr, 'c' },
+        { "replay", required_argument, nullptr, 'r' },
+        { "synthetic", no_argument, nullptr, 's' },
+        { "relay", no_argument, nullptr, 'R' },
+        { nullptr, 0, nullptr, 0 }
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, nullptr)) != -1)
+    {
+        switch (opt)
+        {
+        case 'c':
+            capture_path = optarg;
+            break;
+        case 'r':
+            replay_path = optarg;
+            break;
+        case 's':
+            synthetic = true;
+            break;
+        case 'R':
+            relay = true;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind < argc || (synthetic && !replay_path.empty())
+            || (relay && (synthetic || !replay_path.empty() || !capture_path.empty())))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
     try
     {
         Configuration conf("/etc/powermon.json");
         
+        InfluxdbWriter::Options options;
+        if (relay)
+        {
+            // Fanning in many meters needs more room and larger batches.
+            options.queueSize = 100000;
+            options.batchSize = 5000;
+        }
+        options.queueSize = conf.get("PowerMonitor.InfluxDB.queuesize", options.queueSize);
+        options.batchSize = conf.get("PowerMonitor.InfluxDB.batchsize", options.batchSize);
+        options.batchAge = conf.get("PowerMonitor.InfluxDB.batchage", options.batchAge);
+        options.fullPolicy = InfluxdbWriter::parsePolicy(
+                conf.get<std::string>("PowerMonitor.InfluxDB.fullpolicy", "dropoldest"));
+        options.spoolPath = conf.get<std::string>("PowerMonitor.InfluxDB.spool", "");
+        options.spoolSize = conf.get("PowerMonitor.InfluxDB.spoolsize", options.spoolSize);
+        options.replayInterval = conf.get("PowerMonitor.InfluxDB.replayinterval", options.replayInterval);
+        options.retryInterval = conf.get("PowerMonitor.InfluxDB.retryinterval", options.retryInterval);
+        options.shutdownTimeout = conf.get("PowerMonitor.InfluxDB.shutdowntimeout", options.shutdownTimeout);
+        options.datagramSize = conf.get("PowerMonitor.InfluxDB.datagramsize", options.datagramSize);
+        options.gzipLevel = conf.get("PowerMonitor.InfluxDB.gzip", options.gzipLevel);
+        options.gzipMinSize = conf.get("PowerMonitor.InfluxDB.gzipminsize", options.gzipMinSize);
+        if (relay)
+        {
+            runRelay(conf, options);
+            return 0;
+        }
         InfluxdbWriter influx(
                 conf.get<std::string>("PowerMonitor.InfluxDB.host"),
                 conf.get<std::string>("PowerMonitor.InfluxDB.database"),
                 conf.get<std::string>("PowerMonitor.InfluxDB.username"),
-                conf.get<std::string>("PowerMonitor.InfluxDB.password"));
+                conf.get<std::string>("PowerMonitor.InfluxDB.password"),
+                options);
+        // Full rate points, can be turned off when only the rollups are wanted.
+        bool full_rate = conf.get("PowerMonitor.InfluxDB.fullrate", true);
         
         // 2100 divides evenly with 50 and 3.
         unsigned int sample_rate = conf.get("PowerMonitor.samplerate", 2100);
-        GalileoGen2Adc adc(5, sample_rate);
-        
+        // Block size down to one mains cycle, results every report_blocks blocks.
+        unsigned int block_size = conf.get("PowerMonitor.blocksize", sample_rate);
+        unsigned int report_blocks = conf.get("PowerMonitor.reportblocks", 1);
+        unsigned int kernel_buffers = conf.get("PowerMonitor.kernelbuffers", 4);
         unsigned int mains_freq = conf.get("PowerMonitor.mainsfreq", 50);
-        unsigned int samples_per_cycle = sample_rate / mains_freq;
-        Delay<float> delayL2(2 * samples_per_cycle / 3), delayL3(samples_per_cycle / 3);
-        HighPassFilter<float> hpfV(1.f / sample_rate, 1.f), hpfL1(1.f / sample_rate, 1.f);
-        HighPassFilter<float> hpfL2(1.f / sample_rate, 1.f), hpfL3(1.f / sample_rate, 1.f);
-        std::vector<float> v(sample_rate), l1(sample_rate), l2(sample_rate), l3(sample_rate);
+
+        // A capture file brings its own sampling rate.
+        std::unique_ptr<ReplaySource> replay;
+        if (!replay_path.empty())
+        {
+            replay.reset(new ReplaySource(replay_path, block_size));
+            sample_rate = replay->sampleRate();
+        }
+
+        // Voltage followed by the metered circuits.
+        std::vector<Circuit> circuits = readCircuits(conf, sample_rate, mains_freq);
+        std::unique_ptr<GalileoGen2Adc> adc;
+        std::unique_ptr<SampleSource> source;
+        Acquisition* acquisition = nullptr;
+        if (replay)
+        {
+            if (replay->channels() != circuits.size())
+                throw std::runtime_error("Capture file does not match the configured circuits.");
+            source = std::move(replay);
+        }
+        else if (synthetic)
+        {
+            SyntheticSource::Options synthetic_options;
+            synthetic_options.frequency = conf.get("PowerMonitor.synthetic.frequency", (float) mains_freq);
+            synthetic_options.drift = conf.get("PowerMonitor.synthetic.drift", synthetic_options.drift);
+            synthetic_options.driftPeriod = conf.get("PowerMonitor.synthetic.driftperiod", synthetic_options.driftPeriod);
+            synthetic_options.noise = conf.get("PowerMonitor.synthetic.noise", synthetic_options.noise);
+            synthetic_options.duration = conf.get("PowerMonitor.synthetic.duration", synthetic_options.duration);
+            synthetic_options.realtime = conf.get("PowerMonitor.synthetic.realtime", synthetic_options.realtime);
+            source.reset(new SyntheticSource(sample_rate, block_size,
+                    syntheticWaveforms(conf, circuits), synthetic_options));
+        }
+        else
+        {
+            std::vector<unsigned int> channels;
+            unsigned int adc_channels = 0;
+            for (auto&& c : circuits)
+            {
+                channels.push_back(c.input);
+                adc_channels = std::max(adc_channels, c.input + 1);
+            }
+            adc.reset(new GalileoGen2Adc(adc_channels, sample_rate, block_size, kernel_buffers));
+
+            // Read the ADC on its own thread, in BlockProcessor channel order.
+            acquisition = new Acquisition(*adc, channels, block_size,
+                    conf.get("PowerMonitor.queueblocks", 8),
+                    conf.get("PowerMonitor.realtimepriority", 0));
+            source.reset(acquisition);
+        }
+        std::unique_ptr<CaptureWriter> capture;
+        if (!capture_path.empty())
+            capture.reset(new CaptureWriter(capture_path, circuits.size(), sample_rate));
+
+        // DC removal: first order by default, higher orders cascade biquads.
+        Processor processor(sample_rate, mains_freq, block_size, circuits, report_blocks,
+                conf.get("PowerMonitor.frequencyhysteresis", 10.f),
+                conf.get("PowerMonitor.highpassorder", 1u));
 
         bool print = conf.get("PowerMonitor.print", false);
-        float vRMS, vf;
-        float i1RMS, i2RMS, i3RMS;
-        float p1, p2, p3;
-        float pf1, pf2, pf3;
+        const LineProtocol::Prefix voltagePoint("voltage"), powerPoint("power");
+        LineProtocol lines;
+        std::vector<std::string> powerFactorFields;
+        for (unsigned int i = 1; i <= processor.circuits(); ++i)
+            powerFactorFields.push_back("pf" + std::to_string(i));
 
+        // Change-driven reporting of the voltage and power points, off by default.
+        std::unique_ptr<Deadband> voltage_band, power_band;
+        std::vector<float> voltage_values(2), power_values(2 * processor.circuits());
+        if (conf.has("PowerMonitor.deadband"))
+        {
+            double heartbeat = conf.get("PowerMonitor.deadband.heartbeat", 60.0);
+            bool swinging_door = conf.get("PowerMonitor.deadband.swingingdoor", false);
+            std::vector<Deadband::Rule> rules {
+                readDeadbandRule(conf, "voltage", "voltage"),
+                readDeadbandRule(conf, "frequency", "frequency")
+            };
+            voltage_band.reset(new Deadband(rules, heartbeat, swinging_door));
+            rules.clear();
+            for (unsigned int i = 1; i <= processor.circuits(); ++i)
+                rules.push_back(readDeadbandRule(conf, circuits[i].name, "power"));
+            for (unsigned int i = 0; i < processor.circuits(); ++i)
+                rules.push_back(readDeadbandRule(conf, powerFactorFields[i], "pf"));
+            power_band.reset(new Deadband(rules, heartbeat, swinging_door));
+        }
+
+        // Sag, swell and inrush capture, off by default.
+        std::unique_ptr<EventDetector> events;
+        if (conf.has("PowerMonitor.events"))
+        {
+            std::vector<std::string> names;
+            for (auto&& c : circuits)
+                names.push_back(c.name);
+            events.reset(new EventDetector(sample_rate, mains_freq, block_size, names, readEventOptions(conf),
+                    conf.get("PowerMonitor.events.influxdb", true) ? &influx : nullptr));
+        }
+
+        // Harmonic analysis over each reporting window, off by default.
+        unsigned int max_harmonic = conf.get("PowerMonitor.harmonics", 0);
+        std::vector<Harmonics> harmonics;
+        std::vector<LineProtocol::Prefix> harmonicPoints;
+        std::vector<std::string> harmonicFields;
+        if (max_harmonic > 0)
+        {
+            for (unsigned int c = 0; c < processor.channels(); ++c)
+            {
+                std::string name = c == Processor::Voltage ? "v" : circuits[c].name;
+                harmonics.emplace_back(sample_rate, mains_freq, max_harmonic);
+                harmonicPoints.emplace_back("harmonics", std::map<std::string, std::string>{ { "channel", name } });
+            }
+            for (unsigned int h = 1; h <= harmonics[0].harmonics(); ++h)
+                harmonicFields.push_back("h" + std::to_string(h));
+        }
+
+        // Latest readings for local clients, off by default.
+        std::unique_ptr<ReadingServer> server;
+        std::string server_socket = conf.get<std::string>("PowerMonitor.server.socket", "");
+        unsigned int server_port = conf.get("PowerMonitor.server.port", 0);
+        if (!server_socket.empty() || server_port != 0)
+        {
+            std::vector<std::string> names;
+            for (size_t i = 1; i < circuits.size(); ++i)
+                names.push_back(circuits[i].name);
+            server.reset(new ReadingServer(names, server_socket,
+                    conf.get<std::string>("PowerMonitor.server.address", "127.0.0.1"), server_port));
+        }
+
+        // Filtered waveforms for local readers, off by default.
+        std::unique_ptr<WaveformPublisher> waveforms;
+        std::string waveform_name = conf.get<std::string>("PowerMonitor.waveforms.name", "");
+        if (!waveform_name.empty())
+        {
+            std::vector<std::string> names { "v" };
+            for (size_t i = 1; i < circuits.size(); ++i)
+                names.push_back(circuits[i].name);
+            waveforms.reset(new WaveformPublisher(waveform_name, names, sample_rate, block_size,
+                    conf.get("PowerMonitor.waveforms.slots", 16)));
+        }
+
+        // Aggregation tiers, each written to its own retention policy.
+        std::unique_ptr<Rollup> rollup;
+        std::map<std::string, std::unique_ptr<InfluxdbWriter> > rollup_writers;
+        std::vector<InfluxdbWriter*> tier_writers;
+        std::vector<Rollup::Tier> tiers = readRollupTiers(conf);
+        if (!tiers.empty())
+        {
+            std::vector<std::string> names;
+            for (size_t i = 1; i < circuits.size(); ++i)
+                names.push_back(circuits[i].name);
+            rollup.reset(new Rollup(tiers, names));
+            for (auto&& tier : tiers)
+            {
+                if (tier.retention.empty())
+                {
+                    tier_writers.push_back(&influx);
+                    continue;
+                }
+                std::unique_ptr<InfluxdbWriter>& writer = rollup_writers[tier.retention];
+                if (!writer)
+                {
+                    InfluxdbWriter::Options tier_options = options;
+                    tier_options.retentionPolicy = tier.retention;
+                    if (!tier_options.spoolPath.empty())
+                        tier_options.spoolPath += "." + tier.retention;
+                    writer.reset(new InfluxdbWriter(
+                            conf.get<std::string>("PowerMonitor.InfluxDB.host"),
+                            conf.get<std::string>("PowerMonitor.InfluxDB.database"),
+                            conf.get<std::string>("PowerMonitor.InfluxDB.username"),
+                            conf.get<std::string>("PowerMonitor.InfluxDB.password"),
+                            tier_options));
+                }
+                tier_writers.push_back(writer.get());
+            }
+        }
+
+        // Self-metrics, stage latencies only with POWERMON_METRICS.
+        const LineProtocol::Prefix internalPoint("powermon_internal");
+        long long metrics_interval = conf.get("PowerMonitor.metricsinterval", 60) * 1000000000LL;
+        long long next_metrics = 0;
+
+        auto writeVoltage = [&](const float* values, long long timestamp)
+        {
+            lines.begin(voltagePoint)
+                    .field("voltage", values[0])
+                    .field("frequency", values[1])
+                    .end(timestamp);
+        };
+        auto writePower = [&](const float* values, long long timestamp)
+        {
+            const unsigned int n = processor.circuits();
+            lines.begin(powerPoint);
+            for (unsigned int i = 0; i < n; ++i)
+                lines.field(circuits[i + 1].name.c_str(), values[i]);
+            for (unsigned int i = 0; i < n; ++i)
+                lines.field(powerFactorFields[i].c_str(), values[n + i]);
+            lines.end(timestamp);
+        };
+
+        auto started = std::chrono::steady_clock::now();
+        unsigned long long samples = 0;
+        unsigned long long window_samples = 0;
+        source->start();
         while (!terminate)
         {
-            // Read ADC.
-            adc.refill();
-
-            // Copy data.
-            std::copy(adc.cbegin(V), adc.cend(V), v.begin());
-            std::copy(adc.cbegin(L1), adc.cend(L1), l1.begin());
-            std::copy(adc.cbegin(L2), adc.cend(L2), l2.begin());
-            std::copy(adc.cbegin(L3), adc.cend(L3), l3.begin());
-            // Transform data.
-            // Filtering and delay must be done in order, use for loop.
-            for (auto&& value : v)
-                value = hpfV(voltageToVoltage(value));
-            for (auto&& value : l1)
-                value = hpfL1(voltageToCurrent(value));
-            for (auto&& value : l2)
-                value = delayL2(hpfL2(voltageToCurrent(value)));
-            for (auto&& value : l3)
-                value = delayL3(hpfL3(voltageToCurrent(value)));
-            
-            // Perform calculations.
-            vRMS = Meter::getRMS(v.cbegin(), v.cend());
-            vf = sample_rate * Meter::getFrequency(v.cbegin(), v.cend());
-            i1RMS = Meter::getRMS(l1.cbegin(), l1.cend());
-            i2RMS = Meter::getRMS(l2.cbegin(), l2.cend());
-            i3RMS = Meter::getRMS(l3.cbegin(), l3.cend());
-            p1 = Meter::getAveragePower(l1.cbegin(), l1.cend(), v.cbegin());
-            p2 = Meter::getAveragePower(l2.cbegin(), l2.cend(), v.cbegin());
-            p3 = Meter::getAveragePower(l3.cbegin(), l3.cend(), v.cbegin());
-            pf1 = p1 / (i1RMS * vRMS);
-            pf2 = p2 / (i2RMS * vRMS);
-            pf3 = p3 / (i3RMS * vRMS);
-            
+            // Wait for the next block.
+            const SampleBlock* block = source->next(1000);
+            if (block == nullptr)
+            {
+                if (source->finished())
+                    break;
+                continue;
+            }
+            if (capture)
+                capture->write(*block);
+            samples += block->size;
+            window_samples += block->size;
+
+            // Filter data and perform calculations in one pass.
+            bool ready = processor.process(*block);
+            if (events)
+                events->process(*block, processor);
+            long long block_timestamp = block->timestamp;
+            source->release();
+            if (waveforms)
+            {
+                waveforms->begin(block_timestamp, processor.blockSize());
+                for (unsigned int c = 0; c < processor.channels(); ++c)
+                    waveforms->write(c, processor.signal(c).data(), processor.unitScale(c));
+                waveforms->commit();
+            }
+            if (!harmonics.empty())
+            {
+                StageTimer timer(StageHarmonics);
+                for (unsigned int c = 0; c < harmonics.size(); ++c)
+                    harmonics[c].process(processor.signal(c).data(), processor.blockSize());
+            }
+            if (!ready)
+                continue;
+            const BlockResult& r = processor.result();
+            const unsigned int n = processor.circuits();
+            if (server)
+                server->publish(r);
+
             // Print results.
             if (print)
             {
-                std::cout << vRMS << " V " << vf << " Hz\n";
-                std::cout << i1RMS << " A " << i2RMS << " A " << i3RMS << " A\n";
-                std::cout << p1 << " W " << p2 << " W " << p3 << " W\n";
-                std::cout << pf1 << " " << pf2 << " " << pf3 << "\n";
+                std::cout << r.vRMS << " V " << r.frequency << " Hz\n";
+                for (unsigned int i = 0; i < n; ++i)
+                    std::cout << circuits[i + 1].name << ": " << r.iRMS[i] << " A " << r.power[i] << " W "
+                            << r.powerFactor[i] << "\n";
+                if (acquisition)
+                    std::cout << acquisition->overruns() << " overruns, queue depth "
+                            << acquisition->depth() << " max " << acquisition->maxDepth() << "\n";
+                std::cout << influx.queued() << " lines queued, " << influx.dropped() << " dropped, "
+                        << influx.failures() << " failed writes, " << influx.spooled() << " bytes spooled\n";
             }
             // Send results.
-            influx.send<float>("voltage",
-                    {
-                        { "voltage", vRMS },
-                        { "frequency", vf }
-                    });
-            influx.send<float>("power",
-                    {
-                        { "l1", p1 },
-                        { "l2", p2 },
-                        { "l3", p3 },
-                        { "pf1", pf1 },
-                        { "pf2", pf2 },
-                        { "pf3", pf3 }
-                    });
+            StageTimer timer(StageSerialize);
+            lines.clear();
+            if (full_rate)
+            {
+                voltage_values[0] = r.vRMS;
+                voltage_values[1] = r.frequency;
+                for (unsigned int i = 0; i < n; ++i)
+                {
+                    power_values[i] = r.power[i];
+                    power_values[n + i] = r.powerFactor[i];
+                }
+                unsigned int emit = voltage_band ? voltage_band->update(r.timestamp, voltage_values.data())
+                        : (unsigned int) Deadband::EmitCurrent;
+                if (emit & Deadband::EmitPrevious)
+                    writeVoltage(voltage_band->previous(), voltage_band->previousTimestamp());
+                if (emit & Deadband::EmitCurrent)
+                    writeVoltage(voltage_values.data(), r.timestamp);
+                emit = power_band ? power_band->update(r.timestamp, power_values.data())
+                        : (unsigned int) Deadband::EmitCurrent;
+                if (emit & Deadband::EmitPrevious)
+                    writePower(power_band->previous(), power_band->previousTimestamp());
+                if (emit & Deadband::EmitCurrent)
+                    writePower(power_values.data(), r.timestamp);
+            }
+            for (unsigned int c = 0; c < harmonics.size(); ++c)
+            {
+                harmonics[c].finish(processor.unitScale(c));
+                // Follow the measured mains frequency, ignoring estimates far
+                // from nominal.
+                if (std::fabs(r.frequency - mains_freq) < 0.1 * mains_freq)
+                    harmonics[c].tune(r.frequency, block_size * report_blocks);
+                if (!full_rate)
+                    continue;
+                lines.begin(harmonicPoints[c]);
+                for (unsigned int h = 1; h <= harmonics[c].harmonics(); ++h)
+                    lines.field(harmonicFields[h - 1].c_str(), harmonics[c].magnitude(h));
+                lines.field("thd", harmonics[c].thd());
+                lines.end(r.timestamp);
+            }
+            if (rollup)
+                rollup->add(r, (double) window_samples / sample_rate);
+            window_samples = 0;
+            timer.stop();
+            if (metrics_interval > 0 && r.timestamp >= next_metrics)
+            {
+                if (next_metrics != 0)
+                {
+                    Metrics::write(lines, r.timestamp);
+                    lines.begin(internalPoint);
+                    if (acquisition)
+                        lines.field("overruns", (long long) acquisition->overruns());
+                    if (events)
+                        lines.field("events_dropped", (long long) events->dropped());
+                    if (power_band)
+                        lines.field("suppressed", (long long) (voltage_band->suppressed() + power_band->suppressed()));
+                    lines.field("queued", (long long) influx.queued())
+                            .field("dropped", (long long) influx.dropped())
+                            .field("failures", (long long) influx.failures())
+                            .field("spooled", (long long) influx.spooled())
+                            .end(r.timestamp);
+                }
+                next_metrics = r.timestamp + metrics_interval;
+            }
+            timer.next(StageEnqueue);
+            influx.write(lines);
+            for (unsigned int t = 0; rollup && t < rollup->tiers(); ++t)
+            {
+                if (rollup->lines(t).size() > 0)
+                    tier_writers[t]->write(rollup->lines(t));
+            }
+        }
+        source->stop();
+        if (source->finished())
+        {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+            std::cout << samples << " samples per channel in " << seconds << " s, "
+                    << samples / seconds << " samples/s\n";
         }
     }
     catch (const std::exception& e)
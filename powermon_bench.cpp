@@ -0,0 +1,442 @@
+/*
+ * powermon_bench.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include "BlockProcessor.h"
+#include "Calibration.h"
+#include "Delay.h"
+#include "HighPassFilter.h"
+#include "LineProtocol.h"
+#include "Meter.h"
+#include "SampleConversion.h"
+#include "SyntheticSource.h"
+#include "Transport.h"
+
+using namespace PowerMonitor;
+
+// Minimum measuring time of one benchmark in seconds.
+static const double MIN_TIME = 0.2;
+
+//! Keeps results alive so the benchmarked code is not optimized away.
+static volatile double sink;
+
+//! Result of one benchmark.
+struct Result
+{
+    std::string name;       //!< Benchmark name.
+    std::string unit;       //!< What one item is.
+    unsigned int rate;      //!< Sampling rate in Hz.
+    unsigned int block;     //!< Block size in samples per channel.
+    double ns;              //!< Nanoseconds per item.
+    double bytes;           //!< Bytes per item on the wire, 0 if not applicable.
+};
+
+static std::vector<Result> results;
+
+//! Runs f repeatedly for at least MIN_TIME and records the time per item.
+//! \param f function to run, returns the number of items processed.
+template<class F> static void bench(const char* name, const char* unit, unsigned int rate,
+        unsigned int block, F f)
+{
+    typedef std::chrono::steady_clock Clock;
+    // Warm up caches and branch predictors.
+    f();
+    unsigned long long items = 0;
+    double seconds = 0.0;
+    auto start = Clock::now();
+    do
+    {
+        for (int i = 0; i < 16; ++i)
+            items += f();
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    while (seconds < MIN_TIME);
+    results.push_back(Result { name, unit, rate, block, seconds * 1e9 / items, 0.0 });
+}
+
+//! Gets the CPU time of the calling thread in seconds.
+static double threadCpuTime()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+//! Like bench(), but records the CPU time of the calling thread per item,
+//! leaving out the time spent waiting and in other threads.
+//! \param bytes bytes per item on the wire.
+template<class F> static void benchCpu(const char* name, const char* unit, double bytes, F f)
+{
+    typedef std::chrono::steady_clock Clock;
+    f();
+    unsigned long long items = 0;
+    const double cpu = threadCpuTime();
+    auto start = Clock::now();
+    do
+    {
+        for (int i = 0; i < 16; ++i)
+            items += f();
+    }
+    while (std::chrono::duration<double>(Clock::now() - start).count() < MIN_TIME);
+    results.push_back(Result { name, unit, 0, 0, (threadCpuTime() - cpu) * 1e9 / items, bytes });
+}
+
+//! Generates raw blocks of three phase data with harmonics and noise.
+static std::vector<SampleBlock> generate(unsigned int rate, unsigned int block, unsigned int count)
+{
+    std::vector<SyntheticSource::Waveform> waveforms(4);
+    for (unsigned int c = 0; c < waveforms.size(); ++c)
+    {
+        waveforms[c].amplitude = c == 0 ? 1500.f : 300.f * c;
+        waveforms[c].phase = c == 0 ? 0.f : -120.f * (c - 1) - 20.f;
+        waveforms[c].harmonics = { 0.f, 0.05f, 0.f, 0.02f };
+    }
+    SyntheticSource::Options options;
+    options.noise = 2.f;
+    options.drift = 0.05f;
+    SyntheticSource source(rate, block, waveforms, options);
+    source.start();
+    std::vector<SampleBlock> blocks;
+    for (unsigned int i = 0; i < count; ++i)
+        blocks.push_back(*source.next(0));
+    return blocks;
+}
+
+//! Voltage and three phases with the default calibration and phase delays.
+static std::vector<Circuit> circuits(unsigned int rate, unsigned int mainsFreq)
+{
+    const unsigned int cycle = rate / mainsFreq;
+    return std::vector<Circuit> {
+        { "voltage", 4, 1, voltageGain(), 0 },
+        { "l1", 1, 1, currentGain(), 0 },
+        { "l2", 3, 2, currentGain(), 2 * cycle / 3 },
+        { "l3", 0, 3, currentGain(), cycle / 3 }
+    };
+}
+
+template<class T> static void benchProcessor(const char* name, unsigned int rate, unsigned int block,
+        const std::vector<SampleBlock>& blocks)
+{
+    BlockProcessor<T> processor(rate, 50, block, circuits(rate, 50), rate / block);
+    size_t next = 0;
+    bench(name, "frame", rate, block, [&]()
+    {
+        const SampleBlock& b = blocks[next];
+        next = (next + 1) % blocks.size();
+        if (processor.process(b))
+            sink = processor.result().power[0];
+        return b.size;
+    });
+}
+
+static void run(unsigned int rate, unsigned int block)
+{
+    std::vector<SampleBlock> blocks = generate(rate, block, std::max(1u, 4 * rate / block));
+    const SampleBlock& raw = blocks[0];
+    std::vector<float> v(block), i(block), out(block);
+    convertSamples(raw.channel(0), v.data(), block, raw.scale[0], -2048.f);
+    convertSamples(raw.channel(1), i.data(), block, raw.scale[1], -2048.f);
+
+    bench("meter_rms", "sample", rate, block, [&]()
+    {
+        sink = Meter::getRMS(v.data(), v.data() + block);
+        return block;
+    });
+    bench("meter_average_power", "sample", rate, block, [&]()
+    {
+        sink = Meter::getAveragePower(v.data(), v.data() + block, i.data());
+        return block;
+    });
+    bench("meter_frequency", "sample", rate, block, [&]()
+    {
+        sink = Meter::getFrequency(v.data(), v.data() + block);
+        return block;
+    });
+
+    HighPassFilter<float> filter(1.0 / rate, 1.0);
+    bench("highpass_float", "sample", rate, block, [&]()
+    {
+        for (unsigned int n = 0; n < block; ++n)
+            out[n] = filter(v[n]);
+        sink = out[block - 1];
+        return block;
+    });
+    std::vector<int32_t> q(block), qout(block);
+    for (unsigned int n = 0; n < block; ++n)
+        q[n] = (int32_t) raw.channel(0)[n] << SampleTraits<int32_t>::fractionBits;
+    HighPassFilter<int32_t> fixedFilter(1.0 / rate, 1.0);
+    bench("highpass_fixed", "sample", rate, block, [&]()
+    {
+        for (unsigned int n = 0; n < block; ++n)
+            qout[n] = fixedFilter(q[n]);
+        sink = qout[block - 1];
+        return block;
+    });
+
+    Delay<float> delay(2 * (rate / 50) / 3);
+    bench("delay", "sample", rate, block, [&]()
+    {
+        delay.process(v.data(), out.data(), block);
+        sink = out[block - 1];
+        return block;
+    });
+
+    benchProcessor<float>("block_float", rate, block, blocks);
+    benchProcessor<int32_t>("block_fixed", rate, block, blocks);
+}
+
+static void runSerialization()
+{
+    const LineProtocol::Prefix voltagePoint("voltage"), powerPoint("power");
+    LineProtocol lines;
+    long long timestamp = 1476000000000000000LL;
+    float x = 230.123f;
+    bench("line_protocol", "point", 0, 0, [&]()
+    {
+        lines.clear();
+        for (int n = 0; n < 32; ++n)
+        {
+            timestamp += 1000000000LL;
+            x += 0.001f;
+            lines.begin(voltagePoint).field("voltage", x).field("frequency", 50.01f).end(timestamp);
+            lines.begin(powerPoint)
+                    .field("l1", x * 4.1f).field("l2", x * 8.3f).field("l3", x * 12.7f)
+                    .field("pf1", 0.93f).field("pf2", 0.94f).field("pf3", 0.95f)
+                    .end(timestamp);
+        }
+        sink = lines.size();
+        return 64;
+    });
+}
+
+//! Opens a listening or bound socket on the loopback interface.
+//! \param type SOCK_STREAM or SOCK_DGRAM.
+//! \param port set to the port chosen by the kernel.
+static int loopbackSocket(int type, unsigned int& port)
+{
+    int s = socket(AF_INET, type | SOCK_CLOEXEC, 0);
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t size = sizeof(address);
+    if (s < 0 || bind(s, (struct sockaddr*) &address, size) != 0
+            || (type == SOCK_STREAM && listen(s, 1) != 0)
+            || getsockname(s, (struct sockaddr*) &address, &size) != 0)
+    {
+        perror("loopback socket");
+        exit(1);
+    }
+    port = ntohs(address.sin_port);
+    return s;
+}
+
+//! Stand-in for InfluxDB: answers each write on one connection with 204.
+static void httpSink(int listener)
+{
+    int s = accept(listener, nullptr, nullptr);
+    std::string request;
+    char buffer[65536];
+    ssize_t n;
+    while (s >= 0 && (n = read(s, buffer, sizeof(buffer))) > 0)
+    {
+        request.append(buffer, n);
+        for (;;)
+        {
+            size_t end = request.find("\r\n\r\n");
+            if (end == std::string::npos)
+                break;
+            size_t length = 0;
+            size_t field = request.find("Content-Length:");
+            if (field < end)
+                length = strtoul(request.c_str() + field + 15, nullptr, 10);
+            if (request.size() < end + 4 + length)
+                break;
+            request.erase(0, end + 4 + length);
+            static const char reply[] = "HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n";
+            if (write(s, reply, sizeof(reply) - 1) < 0)
+                break;
+        }
+    }
+    if (s >= 0)
+        close(s);
+}
+
+//! Stand-in for a collector or the UDP listener: discards everything.
+static void discardSink(int s, bool listening)
+{
+    int c = listening ? accept(s, nullptr, nullptr) : s;
+    char buffer[65536];
+    while (c >= 0 && read(c, buffer, sizeof(buffer)) > 0)
+        ;
+    if (listening && c >= 0)
+        close(c);
+}
+
+//! Writes one batch after the other through a transport.
+static void benchTransport(const char* name, Transport& transport, const std::string& payload, unsigned int points,
+        size_t bytes)
+{
+    benchCpu(name, "point", (double) bytes / points, [&]()
+    {
+        transport.start(payload);
+        Transport::Status status;
+        while ((status = transport.poll(100)) == Transport::InFlight)
+            ;
+        if (status != Transport::Sent)
+        {
+            fprintf(stderr, "%s: write failed\n", name);
+            exit(1);
+        }
+        return points;
+    });
+}
+
+static void runTransports()
+{
+    // A typical batch: 50 reports of voltage and three power circuits.
+    const LineProtocol::Prefix voltagePoint("voltage"), powerPoint("power");
+    LineProtocol lines;
+    long long timestamp = 1476000000000000000LL;
+    for (int n = 0; n < 50; ++n)
+    {
+        timestamp += 1000000000LL;
+        lines.begin(voltagePoint).field("voltage", 230.12f + n * 0.01f).field("frequency", 50.01f).end(timestamp);
+        lines.begin(powerPoint)
+                .field("l1", 943.5f + n).field("l2", 1910.2f).field("l3", 2922.7f)
+                .field("pf1", 0.93f).field("pf2", 0.94f).field("pf3", 0.95f)
+                .end(timestamp);
+    }
+    const std::string payload(lines.data(), lines.size());
+    const unsigned int points = 100;
+
+    unsigned int port;
+    int listener = loopbackSocket(SOCK_STREAM, port);
+    std::thread http(httpSink, listener);
+    {
+        HttpTransport transport("http://127.0.0.1:" + std::to_string(port) + "/write?db=bench", "user", "password");
+        benchTransport("transport_http", transport, payload, points, payload.size());
+    }
+    http.join();
+    close(listener);
+
+    // Compression alone, then as part of the write.
+    const int levels[] = { 1, 6, 9 };
+    for (int level : levels)
+    {
+        GzipEncoder encoder(level);
+        const size_t bytes = encoder.compress(payload.data(), payload.size()).size();
+        const std::string name = "gzip_level" + std::to_string(level);
+        benchCpu(name.c_str(), "point", (double) bytes / points, [&]()
+        {
+            sink = encoder.compress(payload.data(), payload.size()).size();
+            return points;
+        });
+    }
+    listener = loopbackSocket(SOCK_STREAM, port);
+    http = std::thread(httpSink, listener);
+    {
+        HttpTransport transport("http://127.0.0.1:" + std::to_string(port) + "/write?db=bench", "user", "password",
+                1, 0);
+        benchTransport("transport_http_gzip1", transport, payload, points,
+                GzipEncoder(1).compress(payload.data(), payload.size()).size());
+    }
+    http.join();
+    close(listener);
+
+    int udp = loopbackSocket(SOCK_DGRAM, port);
+    std::thread datagrams(discardSink, udp, false);
+    {
+        UdpTransport transport("127.0.0.1", std::to_string(port), 1400);
+        benchTransport("transport_udp", transport, payload, points, payload.size());
+    }
+    // Wakes up the blocked read.
+    shutdown(udp, SHUT_RDWR);
+    datagrams.join();
+    close(udp);
+
+    listener = loopbackSocket(SOCK_STREAM, port);
+    std::thread tcp(discardSink, listener, true);
+    {
+        FrameTransport transport("127.0.0.1", std::to_string(port), "");
+        benchTransport("transport_tcp_frames", transport, payload, points, payload.size() + 6);
+    }
+    tcp.join();
+    close(listener);
+
+    std::string path = "/tmp/powermon_bench." + std::to_string(getpid());
+    listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    if (bind(listener, (struct sockaddr*) &address, sizeof(address)) != 0 || listen(listener, 1) != 0)
+    {
+        perror("unix socket");
+        exit(1);
+    }
+    std::thread local(discardSink, listener, true);
+    {
+        FrameTransport transport(path, "");
+        benchTransport("transport_unix_frames", transport, payload, points, payload.size() + 6);
+    }
+    local.join();
+    close(listener);
+    unlink(path.c_str());
+}
+
+int main(int argc, char **argv)
+{
+    bool json = argc > 1 && strcmp(argv[1], "--json") == 0;
+    if (argc > 2 || (argc == 2 && !json))
+    {
+        fprintf(stderr, "Usage: %s [--json]\n", argv[0]);
+        return 1;
+    }
+
+    // One cycle, ten cycles and one second of 50 Hz per block.
+    const unsigned int rates[] = { 2100, 6300 };
+    const unsigned int cycles[] = { 1, 10, 50 };
+    for (unsigned int rate : rates)
+    {
+        for (unsigned int c : cycles)
+            run(rate, c * rate / 50);
+    }
+    runSerialization();
+    runTransports();
+
+    if (json)
+        printf("[\n");
+    else
+        printf("benchmark,unit,rate,block,ns_per_item,items_per_s,bytes_per_item\n");
+    for (size_t n = 0; n < results.size(); ++n)
+    {
+        const Result& r = results[n];
+        if (json)
+            printf("  {\"benchmark\": \"%s\", \"unit\": \"%s\", \"rate\": %u, \"block\": %u, "
+                    "\"ns_per_item\": %.3f, \"items_per_s\": %.0f, \"bytes_per_item\": %.1f}%s\n",
+                    r.name.c_str(), r.unit.c_str(), r.rate, r.block, r.ns, 1e9 / r.ns, r.bytes,
+                    n + 1 < results.size() ? "," : "");
+        else
+            printf("%s,%s,%u,%u,%.3f,%.0f,%.1f\n", r.name.c_str(), r.unit.c_str(), r.rate, r.block, r.ns,
+                    1e9 / r.ns, r.bytes);
+    }
+    if (json)
+        printf("]\n");
+    return 0;
+}
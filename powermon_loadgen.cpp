@@ -0,0 +1,258 @@
+/*
+ * powermon_loadgen.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "LineProtocol.h"
+#include "Transport.h"
+
+using namespace PowerMonitor;
+
+//! Load test settings.
+struct Settings
+{
+    std::string target;         //!< udp://, tcp:// or unix: URL of the relay.
+    unsigned int meters;        //!< Simulated meters, each with its own socket.
+    unsigned int threads;       //!< Sending threads.
+    unsigned int batch;         //!< Points per datagram or frame.
+    double rate;                //!< Points per second over all meters, 0 for as fast as possible.
+    double seconds;             //!< Duration of the test.
+    bool lines;                 //!< Plain lines instead of frames over streams.
+};
+
+//! Simulated meter.
+struct Meter
+{
+    int fd;                     //!< Socket to the relay.
+    LineProtocol::Prefix point; //!< Measurement and meter tag.
+    float phase;                //!< Varies the values.
+};
+
+static std::atomic<unsigned long long> sent(0);
+static std::atomic<unsigned long long> failures(0);
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "Usage: %s [--meters N] [--threads N] [--batch POINTS] [--rate POINTS_PER_S]\n"
+            "          [--seconds S] [--lines] udp://HOST:PORT | tcp://HOST:PORT | unix:PATH\n"
+            "Sends power points like many meters at once, e.g. to powermon --relay.\n"
+            "On the loopback interface each meter sends from its own 127.x.y.z address,\n"
+            "so the relay accounts for them as separate sources.\n", name);
+}
+
+//! Opens the socket of a meter.
+static int connectMeter(const Settings& settings, unsigned int m)
+{
+    const std::string& t = settings.target;
+    if (t.compare(0, 5, "unix:") == 0)
+    {
+        std::string path = t.substr(5);
+        if (path.compare(0, 2, "//") == 0)
+            path = path.substr(2);
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (struct sockaddr*) &address, sizeof(address)) != 0)
+        {
+            perror(path.c_str());
+            exit(1);
+        }
+        return fd;
+    }
+    const bool udp = t.compare(0, 6, "udp://") == 0;
+    if (!udp && t.compare(0, 6, "tcp://") != 0)
+    {
+        fprintf(stderr, "Unsupported target %s\n", t.c_str());
+        exit(1);
+    }
+    std::string address = t.substr(6);
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos)
+    {
+        fprintf(stderr, "Missing port in %s\n", t.c_str());
+        exit(1);
+    }
+    struct sockaddr_in remote;
+    memset(&remote, 0, sizeof(remote));
+    remote.sin_family = AF_INET;
+    remote.sin_port = htons(atoi(address.c_str() + colon + 1));
+    if (inet_pton(AF_INET, address.substr(0, colon).c_str(), &remote.sin_addr) != 1)
+    {
+        fprintf(stderr, "Need an IPv4 address in %s\n", t.c_str());
+        exit(1);
+    }
+    int fd = socket(AF_INET, udp ? SOCK_DGRAM : SOCK_STREAM, 0);
+    if ((ntohl(remote.sin_addr.s_addr) >> 24) == 127)
+    {
+        // One loopback address per meter.
+        struct sockaddr_in local;
+        memset(&local, 0, sizeof(local));
+        local.sin_family = AF_INET;
+        local.sin_addr.s_addr = htonl(0x7f000000u | ((m / 254) % 256) << 8 | (1 + m % 254) | 0x10000u);
+        bind(fd, (struct sockaddr*) &local, sizeof(local));
+    }
+    if (connect(fd, (struct sockaddr*) &remote, sizeof(remote)) != 0)
+    {
+        perror(t.c_str());
+        exit(1);
+    }
+    return fd;
+}
+
+//! Writes all of a buffer to a stream.
+static bool writeAll(int fd, const char* data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+static void run(const Settings& settings, unsigned int thread)
+{
+    typedef std::chrono::steady_clock Clock;
+    const bool udp = settings.target.compare(0, 6, "udp://") == 0;
+    std::vector<Meter> meters;
+    for (unsigned int m = thread; m < settings.meters; m += settings.threads)
+    {
+        char name[16];
+        snprintf(name, sizeof(name), "m%04u", m);
+        meters.push_back(Meter { connectMeter(settings, m),
+                LineProtocol::Prefix("power", std::map<std::string, std::string> { { "meter", name } }),
+                (float) m });
+    }
+    LineProtocol lines;
+    std::string frame;
+    const double rate = settings.rate / settings.threads;
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end = start + std::chrono::microseconds((long long) (settings.seconds * 1e6));
+    unsigned long long points = 0;
+    long long timestamp = std::chrono::system_clock::now().time_since_epoch().count();
+    while (Clock::now() < end && !meters.empty())
+    {
+        for (auto&& meter : meters)
+        {
+            lines.clear();
+            for (unsigned int p = 0; p < settings.batch; ++p)
+            {
+                meter.phase += 0.01f;
+                lines.begin(meter.point)
+                        .field("l1", 900.f + meter.phase).field("l2", 1900.f).field("l3", 2900.f)
+                        .field("pf1", 0.93f).field("pf2", 0.94f).field("pf3", 0.95f)
+                        .end(timestamp + p);
+            }
+            bool ok;
+            if (udp)
+                ok = send(meter.fd, lines.data(), lines.size(), 0) == (ssize_t) lines.size();
+            else if (settings.lines)
+                ok = writeAll(meter.fd, lines.data(), lines.size());
+            else
+            {
+                // The frame of FrameTransport, without a retention policy.
+                const uint32_t length = 2 + lines.size();
+                frame.assign(6, '\0');
+                for (int i = 0; i < 4; ++i)
+                    frame[i] = (char) (length >> (24 - 8 * i));
+                frame[4] = FrameTransport::VERSION;
+                frame.append(lines.data(), lines.size());
+                ok = writeAll(meter.fd, frame.data(), frame.size());
+            }
+            if (ok)
+                points += settings.batch;
+            else
+                failures++;
+        }
+        timestamp += 1000000000LL;
+        if (rate > 0.0)
+            std::this_thread::sleep_until(start + std::chrono::microseconds((long long) (points / rate * 1e6)));
+    }
+    for (auto&& meter : meters)
+        close(meter.fd);
+    sent += points;
+}
+
+int main(int argc, char **argv)
+{
+    Settings settings = { "", 50, 2, 10, 0.0, 10.0, false };
+    static const struct option long_options[] = {
+        { "meters", required_argument, nullptr, 'm' },
+        { "threads", required_argument, nullptr, 't' },
+        { "batch", required_argument, nullptr, 'b' },
+        { "rate", required_argument, nullptr, 'r' },
+        { "seconds", required_argument, nullptr, 's' },
+        { "lines", no_argument, nullptr, 'l' },
+        { nullptr, 0, nullptr, 0 }
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, nullptr)) != -1)
+    {
+        switch (opt)
+        {
+        case 'm':
+            settings.meters = atoi(optarg);
+            break;
+        case 't':
+            settings.threads = atoi(optarg);
+            break;
+        case 'b':
+            settings.batch = atoi(optarg);
+            break;
+        case 'r':
+            settings.rate = atof(optarg);
+            break;
+        case 's':
+            settings.seconds = atof(optarg);
+            break;
+        case 'l':
+            settings.lines = true;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind + 1 != argc || settings.meters == 0 || settings.threads == 0 || settings.batch == 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    settings.target = argv[optind];
+    settings.threads = std::min(settings.threads, settings.meters);
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < settings.threads; ++t)
+        threads.push_back(std::thread(run, std::cref(settings), t));
+    for (auto&& t : threads)
+        t.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%llu points from %u meters in %.2f s, %.0f points/s, %llu failed sends\n",
+            sent.load(), settings.meters, seconds, sent / seconds, failures.load());
+    return 0;
+}
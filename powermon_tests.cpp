@@ -0,0 +1,1095 @@
+/*
+ * powermon_tests.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "BlockProcessor.h"
+#include "Calibration.h"
+#include "Deadband.h"
+#include "FilterBank.h"
+#include "FrequencyEstimator.h"
+#include "Harmonics.h"
+#include "HighPassFilter.h"
+#include "LineProtocol.h"
+#include "Meter.h"
+#include "Rollup.h"
+#include "Spool.h"
+#include "SyntheticSource.h"
+#include "Transport.h"
+
+using namespace PowerMonitor;
+
+//! Heap allocations so far, counted by the replaced operator new.
+static std::atomic<unsigned long long> allocations(0);
+
+// Not inlined, or GCC warns about malloc() and free() mismatching new and delete.
+__attribute__((noinline)) void* operator new(size_t size)
+{
+    allocations++;
+    void* p = std::malloc(size ? size : 1);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+//! Failed checks of the running test.
+static unsigned int failures;
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+#define CHECK_NEAR(value, expected, tolerance) checkNear((value), (expected), (tolerance), \
+        #value, __FILE__, __LINE__)
+
+static void check(bool ok, const char* condition, const char* file, int line)
+{
+    if (ok)
+        return;
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, condition);
+    failures++;
+}
+
+static void checkNear(double value, double expected, double tolerance, const char* name,
+        const char* file, int line)
+{
+    if (std::fabs(value - expected) <= tolerance)
+        return;
+    fprintf(stderr, "%s:%d: %s is %.9g, expected %.9g +- %.3g\n", file, line, name, value, expected, tolerance);
+    failures++;
+}
+
+//! Serializing points does not allocate once the buffer has grown.
+static void testLineProtocolAllocations()
+{
+    LineProtocol::Prefix power("power", { { "host", "galileo" }, { "site", "home" } });
+    LineProtocol lines(64);
+    long long timestamp = 1476800000000000000LL;
+    for (int round = 0; round < 2; ++round)
+    {
+        // The first round grows the buffer, which shows that allocations
+        // are counted. The second must not allocate.
+        unsigned long long before = allocations;
+        for (int i = 0; i < 10000; ++i)
+        {
+            if (i % 100 == 0)
+                lines.clear();
+            float x = 0.37f * i;
+            lines.begin(power)
+                    .field("l1", x).field("l2", -2.f * x).field("l3", 1e-7f * x)
+                    .field("pf1", 0.93f).field("energy", 3600.25 * i).field("count", (long long) i)
+                    .field("ok", true)
+                    .end(timestamp + i);
+            lines.begin("voltage").tag("phase", "1").field("voltage", 230.1f).end(timestamp + i);
+        }
+        if (round == 0)
+            CHECK(allocations > before);
+        else
+            CHECK(allocations == before);
+    }
+}
+
+//! Formatted numbers read back as the same value.
+static void testLineProtocolRoundTrip()
+{
+    char text[40];
+    size_t n = LineProtocol::formatFloat(230.1f, text);
+    CHECK(std::string(text, n) == "230.1");
+    n = LineProtocol::formatFloat(-0.001f, text);
+    CHECK(std::string(text, n) == "-0.001");
+    n = LineProtocol::formatDouble(0.1, text);
+    CHECK(std::string(text, n) == "0.1");
+    n = LineProtocol::formatDouble(1e15, text);
+    CHECK(std::strtod(std::string(text, n).c_str(), nullptr) == 1e15);
+
+    std::mt19937_64 random(1);
+    unsigned int floatErrors = 0, doubleErrors = 0;
+    for (int i = 0; i < 1000000; ++i)
+    {
+        // Random mantissas, magnitudes from 2^-30 to 2^60, both signs.
+        unsigned long long bits = random();
+        int exponent = (int) (bits >> 56) % 91 - 30;
+        double d = std::ldexp((double) ((bits & ((1ULL << 52) - 1)) | (1ULL << 52)), exponent - 52);
+        if (bits & (1ULL << 63))
+            d = -d;
+        // Also doubles widened from floats, these need 16 or 17 digits.
+        if (i % 2)
+            d = (float) d;
+        n = LineProtocol::formatDouble(d, text);
+        text[n] = '\0';
+        if (std::strtod(text, nullptr) != d && doubleErrors++ < 5)
+            fprintf(stderr, "%.17g formatted as %s\n", d, text);
+        float f = (float) d;
+        n = LineProtocol::formatFloat(f, text);
+        text[n] = '\0';
+        if (std::strtof(text, nullptr) != f && floatErrors++ < 5)
+            fprintf(stderr, "%.9g formatted as %s\n", f, text);
+    }
+    CHECK(doubleErrors == 0);
+    CHECK(floatErrors == 0);
+}
+
+//! Feeds two seconds of a 230 V sine to a frequency estimator.
+//!
+//! Integer samples are ADC codes of 0.25 V in Q8, as in the fixed-point path.
+//! \param frequency frequency of the sine in Hz.
+//! \param noise standard deviation of added white noise in volts.
+//! \param cycleTolerance largest error of a single cycle in Hz.
+//! \param averageTolerance largest error of the average in Hz.
+template<class T> static void checkFrequency(double frequency, double noise, double cycleTolerance,
+        double averageTolerance)
+{
+    // As in BlockProcessor: 10 V hysteresis, holdoff of 3/4 nominal cycle.
+    const unsigned int rate = 2100;
+    const double unit = std::is_integral<T>::value ? 0.25 / 256 : 1.0;
+    FrequencyEstimator<T> estimator(rate, (T) (10.0 / unit), 3 * (rate / 50) / 4);
+    std::mt19937 random(7);
+    std::normal_distribution<double> gaussian(0.0, noise > 0.0 ? noise : 1.0);
+    double worst = 0.0;
+    for (unsigned int i = 0; i < 2 * rate; ++i)
+    {
+        double v = 325.27 * std::sin(2 * M_PI * frequency * i / rate + 1.0);
+        if (noise > 0.0)
+            v += gaussian(random);
+        T sample = std::is_integral<T>::value ? (T) (std::lround(v / 0.25) * 256) : (T) v;
+        if (estimator(sample))
+            worst = std::max(worst, std::fabs(estimator.frequency() - frequency));
+    }
+    // One cycle less than the cycles in the signal: the first crossing only starts one.
+    CHECK_NEAR(estimator.cycles(), 2 * frequency - 1, 1.0);
+    CHECK_NEAR(estimator.average(), frequency, averageTolerance);
+    CHECK_NEAR(worst, 0.0, cycleTolerance);
+}
+
+//! Frequency estimates of clean and noisy sines off the nominal frequency.
+static void testFrequencyEstimator()
+{
+    const double frequencies[] = { 49.5, 50.0, 50.2, 60.0 };
+    for (double f : frequencies)
+    {
+        // Clean: only the interpolation error of the sine near zero.
+        checkFrequency<float>(f, 0.0, 0.002, 0.001);
+        // Quantized to ADC codes.
+        checkFrequency<int32_t>(f, 0.0, 0.01, 0.001);
+        // 3 V of noise, about 1 % of the amplitude, must not add crossings.
+        // It jitters single cycles, the average over the window much less.
+        checkFrequency<float>(f, 3.0, 0.5, 0.005);
+        checkFrequency<int32_t>(f, 3.0, 0.5, 0.005);
+    }
+}
+
+//! Filters each lane as planar blocks and frame by frame, and checks both
+//! against a HighPassFilter per lane.
+template<class T> static void checkFilterBank()
+{
+    // Six lanes: four in an SSE register and two in the scalar tail.
+    const unsigned int lanes = 6, rate = 2100;
+    const size_t blocks[] = { 1, 41, 210, 2100 };
+    HighPassFilterBank<T> planar(lanes, 1.0 / rate, 1.0);
+    HighPassFilterBank<T> frames(lanes, 1.0 / rate, 1.0);
+    std::vector<HighPassFilter<T> > reference(lanes, HighPassFilter<T>(1.0 / rate, 1.0));
+    std::vector<std::vector<T> > x(lanes, std::vector<T>(2100));
+    std::vector<T*> pointers(lanes);
+    std::vector<T> frame(lanes);
+    std::mt19937 random(5);
+    std::uniform_int_distribution<int> code(0, 4095);
+    size_t mismatches = 0;
+    for (size_t size : blocks)
+    {
+        for (unsigned int l = 0; l < lanes; ++l)
+        {
+            for (size_t i = 0; i < size; ++i)
+                x[l][i] = (T) (code(random) << 8);
+            pointers[l] = x[l].data();
+        }
+        std::vector<std::vector<T> > y = x;
+        for (size_t i = 0; i < size; ++i)
+        {
+            for (unsigned int l = 0; l < lanes; ++l)
+                frame[l] = y[l][i];
+            frames(frame.data());
+            for (unsigned int l = 0; l < lanes; ++l)
+            {
+                const T expected = reference[l](y[l][i]);
+                mismatches += frame[l] != expected;
+                y[l][i] = expected;
+            }
+        }
+        planar.process(pointers.data(), size);
+        for (unsigned int l = 0; l < lanes; ++l)
+            mismatches += !std::equal(y[l].begin(), y[l].begin() + size, x[l].begin());
+    }
+    CHECK(mismatches == 0);
+}
+
+//! Scalar biquad cascade of one channel in transposed direct form II.
+class ReferenceCascade
+{
+public:
+    ReferenceCascade(const std::vector<Biquad<float> >& sections) :
+            _sections(sections),
+            _s1(sections.size()),
+            _s2(sections.size()),
+            _initialized(false)
+    {
+    }
+
+    float operator()(float x)
+    {
+        for (size_t s = 0; s < _sections.size(); ++s)
+        {
+            const Biquad<float>& c = _sections[s];
+            if (!_initialized)
+            {
+                // Constant input and output at the first sample.
+                _s2[s] = (c.b2 - c.a2) * x;
+                _s1[s] = (c.b1 - c.a1) * x + _s2[s];
+                continue;
+            }
+            float y = c.b0 * x + _s1[s];
+            _s1[s] = c.b1 * x - c.a1 * y + _s2[s];
+            _s2[s] = c.b2 * x - c.a2 * y;
+            x = y;
+        }
+        _initialized = true;
+        return x;
+    }
+
+private:
+    std::vector<Biquad<float> > _sections;
+    std::vector<float> _s1;
+    std::vector<float> _s2;
+    bool _initialized;
+};
+
+//! Filters each lane through a biquad cascade as planar blocks and frame
+//! by frame, and checks both against the scalar reference cascade.
+static void checkBiquadBank(unsigned int order)
+{
+    const unsigned int lanes = 6, rate = 2100;
+    const size_t blocks[] = { 1, 41, 210, 2100 };
+    const std::vector<Biquad<float> > sections = Biquad<float>::butterworthHighPass(order, 1.0 / rate, 1.0);
+    BiquadFilterBank<float> planar(lanes, sections);
+    BiquadFilterBank<float> frames(lanes, sections);
+    std::vector<ReferenceCascade> reference(lanes, ReferenceCascade(sections));
+    std::vector<std::vector<float> > x(lanes, std::vector<float>(2100));
+    std::vector<float*> pointers(lanes);
+    std::vector<float> frame(lanes);
+    std::mt19937 random(order);
+    std::uniform_int_distribution<int> code(0, 4095);
+    size_t mismatches = 0;
+    for (size_t size : blocks)
+    {
+        for (unsigned int l = 0; l < lanes; ++l)
+        {
+            // A DC offset per lane, as the ADC delivers it.
+            for (size_t i = 0; i < size; ++i)
+                x[l][i] = 0.4f * code(random) + 100.f * l;
+            pointers[l] = x[l].data();
+        }
+        std::vector<std::vector<float> > y = x;
+        for (size_t i = 0; i < size; ++i)
+        {
+            for (unsigned int l = 0; l < lanes; ++l)
+                frame[l] = y[l][i];
+            frames(frame.data());
+            for (unsigned int l = 0; l < lanes; ++l)
+            {
+                const float expected = reference[l](y[l][i]);
+                mismatches += frame[l] != expected;
+                y[l][i] = expected;
+            }
+        }
+        planar.process(pointers.data(), size);
+        for (unsigned int l = 0; l < lanes; ++l)
+            mismatches += !std::equal(y[l].begin(), y[l].begin() + size, x[l].begin());
+    }
+    CHECK(mismatches == 0);
+}
+
+//! The filter banks give exactly the results of the scalar filters, and
+//! a block processor with a higher-order filter measures the same signal.
+static void testFilterBank()
+{
+    checkFilterBank<float>();
+    checkFilterBank<int32_t>();
+    for (unsigned int order = 1; order <= 4; ++order)
+        checkBiquadBank(order);
+
+    // Once settled, the fourth order passes 50 Hz within 0.01 % of the
+    // unfiltered signal. The first order, as HighPassFilter computes its
+    // coefficient, attenuates it by 0.17 %.
+    const unsigned int rate = 2100, block = 2100;
+    std::vector<SyntheticSource::Waveform> waveforms = {
+        { 1500.f, 0.f, {} },
+        { 700.f, -30.f, {} }
+    };
+    std::vector<Circuit> channels = {
+        { "voltage", 4, 1, voltageGain(), 0 },
+        { "l1", 1, 1, currentGain(), 0 }
+    };
+    SyntheticSource source(rate, block, waveforms);
+    source.start();
+    BlockProcessor<float> first(rate, 50, block, channels);
+    BlockProcessor<float> fourth(rate, 50, block, channels, 1, 10.f, 4);
+    std::vector<float> v(block);
+    for (int i = 0; i < 10; ++i)
+    {
+        const SampleBlock& b = *source.next(0);
+        first.process(b);
+        fourth.process(b);
+        convertSamples(b.channel(0), v.data(), block, b.scale[0] * channels[0].gain, b.offset[0]);
+    }
+    // The AC part of the unfiltered signal, whole cycles without the offset.
+    const double total = Meter::getRMS(v.begin(), v.end()), mean = Meter::getAverage(v.begin(), v.end());
+    const double rms = std::sqrt(total * total - mean * mean);
+    CHECK_NEAR(fourth.result().vRMS, rms, rms * 1e-4);
+    CHECK_NEAR(first.result().vRMS, rms * 0.99826, rms * 1e-4);
+
+    // No fixed-point form.
+    bool rejected = false;
+    try
+    {
+        BlockProcessor<int32_t> fixed(rate, 50, block, channels, 1, 10.f, 2);
+    }
+    catch (const std::runtime_error&)
+    {
+        rejected = true;
+    }
+    CHECK(rejected);
+}
+
+//! Harmonics of a sine off the nominal frequency, tuned to its frequency.
+//!
+//! The fundamental is within 0.01 %. The harmonics, including the leakage
+//! into the even ones, are within 0.05 % of the nominal 230 V, the IEC
+//! 61000-4-7 class I accuracy for small harmonics.
+static void testHarmonics()
+{
+    const unsigned int rate = 2100, window = 2100;
+    const double frequencies[][2] = { { 49.5, 50.0 }, { 50.2, 50.0 }, { 59.7, 60.0 } };
+    for (auto&& f : frequencies)
+    {
+        Harmonics harmonics(rate, f[1], 9);
+        harmonics.tune(f[0], window);
+        std::vector<float> x(window);
+        for (unsigned int i = 0; i < window; ++i)
+        {
+            const double t = 2 * M_PI * f[0] * i / rate;
+            x[i] = 325.27 * std::sin(t + 1.0) + 16.26 * std::sin(3 * t + 0.3) + 9.76 * std::sin(5 * t + 2.0);
+        }
+        // In blocks, as BlockProcessor exposes the signals.
+        for (unsigned int i = 0; i < window; i += 210)
+            harmonics.process(x.data() + i, 210);
+        harmonics.finish();
+        const double tolerance = 230.0 * 5e-4;
+        CHECK_NEAR(harmonics.magnitude(1), 325.27 / M_SQRT2, 230.0 * 1e-4);
+        CHECK_NEAR(harmonics.magnitude(3), 16.26 / M_SQRT2, tolerance);
+        CHECK_NEAR(harmonics.magnitude(5), 9.76 / M_SQRT2, tolerance);
+        for (unsigned int h = 2; h <= 8; h += 2)
+            CHECK_NEAR(harmonics.magnitude(h), 0.0, tolerance);
+    }
+}
+
+//! Fixed-point results agree with the float path on the same blocks.
+//!
+//! Tolerances: RMS and power within 0.01 %, plus 1 mA and 0.1 W for the
+//! small load, and power factor within 0.0001.
+static void testFixedPoint()
+{
+    const unsigned int rate = 2100, block = 210, cycle = rate / 50;
+    // Voltage, a large and a small load, and a phase 3 circuit with harmonics.
+    std::vector<SyntheticSource::Waveform> waveforms = {
+        { 1500.f, 0.f, { 0.f, 0.03f } },
+        { 900.f, -25.f, {} },
+        { 12.f, -120.f, {} },
+        { 400.f, -240.f, { 0.f, 0.2f, 0.f, 0.1f } }
+    };
+    std::vector<Circuit> channels = {
+        { "voltage", 4, 1, voltageGain(), 0 },
+        { "l1", 1, 1, currentGain(), 0 },
+        { "l2", 3, 2, currentGain(), 2 * cycle / 3 },
+        { "l3", 0, 3, currentGain(), cycle / 3 }
+    };
+    SyntheticSource::Options options;
+    options.noise = 2.f;
+    options.drift = 0.2f;
+    options.driftPeriod = 5.f;
+    SyntheticSource source(rate, block, waveforms, options);
+    source.start();
+    BlockProcessor<float> floating(rate, 50, block, channels, rate / block);
+    BlockProcessor<int32_t> fixed(rate, 50, block, channels, rate / block);
+    unsigned int windows = 0;
+    while (windows < 12)
+    {
+        const SampleBlock& b = *source.next(0);
+        bool done = floating.process(b);
+        CHECK(fixed.process(b) == done);
+        // The filters take about two seconds to remove the mid-scale offset.
+        if (!done || windows++ < 2)
+            continue;
+        const BlockResult& f = floating.result();
+        const BlockResult& x = fixed.result();
+        CHECK_NEAR(x.vRMS, f.vRMS, 1e-4 * f.vRMS);
+        CHECK_NEAR(x.frequency, f.frequency, 0.001);
+        for (unsigned int i = 0; i < floating.circuits(); ++i)
+        {
+            CHECK_NEAR(x.iRMS[i], f.iRMS[i], 1e-4 * f.iRMS[i] + 0.001);
+            CHECK_NEAR(x.power[i], f.power[i], 1e-4 * std::fabs(f.power[i]) + 0.1);
+            CHECK_NEAR(x.powerFactor[i], f.powerFactor[i], 1e-4);
+        }
+    }
+}
+
+//! Gets a tolerance relative to a reference value.
+static double bound(double tolerance, double reference)
+{
+    return tolerance * std::fabs(reference);
+}
+
+//! The float kernels of Meter match the iterator reference within the
+//! documented tolerance, and so do the sums of BlockProcessor.
+static void testMeterKernels()
+{
+    const size_t sizes[] = { 1, 3, 4, 5, 7, 8, 42, 421, 2100, 6300, 100000 };
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> noise(-5.f, 5.f);
+    for (size_t n : sizes)
+    {
+        // Sines with an offset, as the kernels see them before filtering.
+        std::vector<float> x(n), y(n);
+        double absolute = 0.0, total = 0.0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            x[i] = 325.f * std::sin(0.15f * i) + 12.f + noise(random);
+            y[i] = 20.f * std::sin(0.15f * i - 0.4f) + noise(random) / 10.f;
+            absolute += std::fabs((double) x[i] * y[i]);
+            total += std::fabs(x[i]);
+        }
+        // Iterators other than pointers run the single precision reference.
+        const float rmsReference = Meter::getRMS(x.begin(), x.end());
+        const float averageReference = Meter::getAverage(x.begin(), x.end());
+        const float powerReference = Meter::getAveragePower(x.begin(), x.end(), y.begin());
+        const float* px = x.data();
+        const float* py = y.data();
+        // |kernel - reference| <= n * 2^-24 * sum(|x_i * y_i|) / n, and
+        // n * 2^-25 relative for the RMS, plus rounding of the result.
+        const double u = std::ldexp(1.0, -24);
+        CHECK_NEAR(Meter::getRMS(px, px + n), rmsReference, bound(n * u / 2 + u, rmsReference));
+        CHECK_NEAR(Meter::getAverage(px, px + n), averageReference, n * u * total / n + bound(u, averageReference));
+        CHECK_NEAR(Meter::getAveragePower(px, px + n, py), powerReference,
+                n * u * absolute / n + bound(u, powerReference));
+        // The kernels themselves are close to exact.
+        double exact = 0.0;
+        for (size_t i = 0; i < n; ++i)
+            exact += (double) x[i] * y[i];
+        CHECK_NEAR(Meter::dot(px, py, n), exact, bound(1e-12, absolute));
+    }
+
+    // A block processor window of one block gives the RMS and power of the
+    // filtered signals it exposes.
+    const unsigned int rate = 2100, block = 2100;
+    std::vector<SyntheticSource::Waveform> waveforms = {
+        { 1500.f, 0.f, {} },
+        { 700.f, -30.f, {} }
+    };
+    std::vector<Circuit> channels = {
+        { "voltage", 4, 1, voltageGain(), 0 },
+        { "l1", 1, 1, currentGain(), 0 }
+    };
+    SyntheticSource source(rate, block, waveforms);
+    source.start();
+    BlockProcessor<float> processor(rate, 50, block, channels);
+    for (int i = 0; i < 3; ++i)
+        CHECK(processor.process(*source.next(0)));
+    const std::vector<float>& v = processor.signal(0);
+    const std::vector<float>& c = processor.signal(1);
+    const BlockResult& r = processor.result();
+    const double u = std::ldexp(1.0, -24);
+    CHECK_NEAR(r.vRMS, Meter::getRMS(v.begin(), v.end()), bound(block * u / 2 + u, r.vRMS));
+    CHECK_NEAR(r.iRMS[0], Meter::getRMS(c.begin(), c.end()), bound(block * u / 2 + u, r.iRMS[0]));
+    CHECK_NEAR(r.power[0], Meter::getAveragePower(v.begin(), v.end(), c.begin()),
+            block * u * r.vRMS * r.iRMS[0] + bound(u, r.power[0]));
+}
+
+//! Opens a listening socket on an ephemeral loopback port.
+//! \param type SOCK_DGRAM or SOCK_STREAM.
+//! \param port set to the port number.
+//! \return Socket, or -1 on failure.
+static int listenLoopback(int type, std::string& port)
+{
+    int s = socket(AF_INET, type | SOCK_CLOEXEC, 0);
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t size = sizeof(address);
+    if (s < 0 || bind(s, (struct sockaddr*) &address, size) != 0
+            || (type == SOCK_STREAM && listen(s, 4) != 0)
+            || getsockname(s, (struct sockaddr*) &address, &size) != 0)
+    {
+        if (s >= 0)
+            close(s);
+        return -1;
+    }
+    port = std::to_string(ntohs(address.sin_port));
+    return s;
+}
+
+//! Waits until a socket is readable, for at most two seconds.
+static bool readable(int s)
+{
+    struct pollfd p = { s, POLLIN, 0 };
+    return poll(&p, 1, 2000) == 1;
+}
+
+//! Lines are packed greedily into datagrams of at most the datagram size,
+//! and a longer line goes out alone.
+static void testUdpTransport()
+{
+    std::string port;
+    int server = listenLoopback(SOCK_DGRAM, port);
+    CHECK(server >= 0);
+    if (server < 0)
+        return;
+    const size_t limit = 100;
+    std::string payload;
+    std::vector<std::string> lines;
+    for (unsigned int i = 0; i < 12; ++i)
+    {
+        // Lines of 20 to 42 bytes, and one of 250 in the middle.
+        std::string line = "power,circuit=l" + std::to_string(i % 3) + " p=" + std::string(i * 2, '9') + "\n";
+        if (i == 6)
+            line = "power p=\"" + std::string(239, 'x') + "\"\n";
+        lines.push_back(line);
+        payload += line;
+    }
+    UdpTransport transport("127.0.0.1", port, limit);
+    transport.start(payload);
+    CHECK(transport.poll(0) == Transport::Sent);
+
+    // Everything was sent by start(), so all of it is queued by now.
+    std::vector<std::string> datagrams;
+    char buffer[1024];
+    ssize_t n;
+    CHECK(readable(server));
+    while ((n = recv(server, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0)
+        datagrams.push_back(std::string(buffer, n));
+    std::string received;
+    size_t line = 0;
+    for (auto&& d : datagrams)
+    {
+        // Whole lines only, within the limit unless a single line.
+        size_t count = std::count(d.begin(), d.end(), '\n');
+        CHECK(!d.empty() && d.back() == '\n');
+        CHECK(d.size() <= limit || count == 1);
+        // Greedy: the next line would not have fit.
+        line += count;
+        if (line < lines.size())
+            CHECK(d.size() + lines[line].size() > limit);
+        received += d;
+    }
+    CHECK(received == payload);
+    CHECK(std::count(datagrams.begin(), datagrams.end(), lines[6]) == 1);
+    close(server);
+}
+
+//! Frames carry the length, version and retention policy, and a new
+//! connection is opened once the collector has closed the last one.
+static void testFrameTransport()
+{
+    const std::string policies[] = { "autogen", "" };
+    const std::string payload = "power,circuit=l1 p=230.5 1500000000000000000\n"
+            "power,circuit=l2 p=12 1500000000000000000\n";
+    for (auto&& policy : policies)
+    {
+        std::string port;
+        int server = listenLoopback(SOCK_STREAM, port);
+        CHECK(server >= 0);
+        if (server < 0)
+            return;
+        std::string expected(4, '\0');
+        const uint32_t length = 2 + policy.size() + payload.size();
+        for (int i = 0; i < 4; ++i)
+            expected[i] = (char) (length >> (24 - 8 * i));
+        expected += (char) FrameTransport::VERSION;
+        expected += (char) policy.size();
+        expected += policy + payload;
+
+        FrameTransport transport("127.0.0.1", port, policy);
+        for (int frame = 0; frame < 2; ++frame)
+        {
+            transport.start(payload);
+            Transport::Status status = Transport::InFlight;
+            for (int i = 0; i < 200 && status == Transport::InFlight; ++i)
+                status = transport.poll(10);
+            CHECK(status == Transport::Sent);
+            const bool connected = readable(server);
+            CHECK(connected);
+            int peer = connected ? accept(server, nullptr, nullptr) : -1;
+            if (peer < 0)
+                break;
+            std::string received;
+            char buffer[256];
+            while (received.size() < expected.size() && readable(peer))
+            {
+                ssize_t n = recv(peer, buffer, sizeof(buffer), 0);
+                if (n <= 0)
+                    break;
+                received.append(buffer, n);
+            }
+            CHECK(received == expected);
+            // The collector goes away; give the close time to reach the
+            // transport before the next frame.
+            close(peer);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        close(server);
+    }
+}
+
+//! Written sample of a deadband test.
+struct DeadbandPoint
+{
+    long long   timestamp;
+    float       values[2];
+};
+
+//! Runs ramps, steps, noise, a NaN and a constant stretch longer than the
+//! heartbeat through a deadband and reconstructs every sample from the
+//! written ones: step-wise for the plain deadband, by linear interpolation
+//! for the swinging door.
+//! \return Number of written samples.
+static size_t checkDeadband(bool swingingDoor)
+{
+    const std::vector<Deadband::Rule> rules { { 0.5f, 0.f }, { 0.05f, 0.001f } };
+    const long long second = 1000000000LL;
+    const long long heartbeat = 30 * second;
+    const unsigned int n = 1000;
+    std::mt19937 random(21);
+    std::uniform_real_distribution<float> noise(-1.f, 1.f);
+    std::vector<DeadbandPoint> samples(n);
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        float power;
+        if (i < 200)
+            power = 100.f + 0.2f * i;
+        else if (i < 300)
+            power = (i < 250 ? 500.f : 300.f) + 0.3f * noise(random);
+        else if (i == 300)
+            power = NAN;
+        else if (i < 400)
+            power = 300.f - 0.4f * (i - 300) + 0.1f * noise(random);
+        else if (i < 600)
+            power = 50.f;
+        else
+            power = 100.f + 50.f * std::sin(i * 0.01f) + 0.3f * noise(random);
+        samples[i].timestamp = 1476800000000000000LL + i * second;
+        samples[i].values[0] = power;
+        samples[i].values[1] = (i < 700 ? 230.f : 240.f) + 2.f * std::sin(i * 0.01f);
+    }
+
+    Deadband deadband(rules, heartbeat / 1e9, swingingDoor);
+    std::vector<DeadbandPoint> points;
+    points.reserve(2 * n);
+    std::vector<bool> written(n);
+    unsigned long long allocated = 0;
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        const unsigned long long before = allocations;
+        const unsigned int emit = deadband.update(samples[i].timestamp, samples[i].values);
+        allocated += allocations - before;
+        if (emit & Deadband::EmitPrevious)
+        {
+            CHECK(swingingDoor && i > 0 && deadband.previousTimestamp() == samples[i - 1].timestamp);
+            DeadbandPoint p = { deadband.previousTimestamp(), { deadband.previous()[0], deadband.previous()[1] } };
+            points.push_back(p);
+            written[i - 1] = true;
+        }
+        if (emit & Deadband::EmitCurrent)
+        {
+            points.push_back(samples[i]);
+            written[i] = true;
+        }
+    }
+    CHECK(allocated == 0);
+    // The last sample may still be pending.
+    const size_t unwritten = std::count(written.begin(), written.end(), false);
+    CHECK(deadband.suppressed() == unwritten - (written[n - 1] ? 0 : 1));
+
+    size_t k = 0;
+    for (unsigned int i = 0; i < n && samples[i].timestamp <= points.back().timestamp; ++i)
+    {
+        // Segment of the written samples around this one.
+        while (k + 1 < points.size() && points[k + 1].timestamp < samples[i].timestamp)
+            ++k;
+        const DeadbandPoint& a = points[k];
+        const DeadbandPoint& b = k + 1 < points.size() ? points[k + 1] : a;
+        CHECK(b.timestamp - a.timestamp <= heartbeat);
+        const long long t = samples[i].timestamp;
+        const DeadbandPoint* own = a.timestamp == t ? &a : (b.timestamp == t ? &b : nullptr);
+        for (unsigned int f = 0; f < 2; ++f)
+        {
+            const float value = samples[i].values[f];
+            if (own && (own->values[f] == value || (std::isnan(own->values[f]) && std::isnan(value))))
+                continue;
+            // Only the swinging door moves a written sample, within its band.
+            CHECK(!own || swingingDoor);
+            double reconstructed = a.values[f];
+            if (swingingDoor)
+            {
+                const double x = (double) (t - a.timestamp) / (b.timestamp - a.timestamp);
+                reconstructed += x * (b.values[f] - a.values[f]);
+            }
+            const double band = std::max(rules[f].absolute, rules[f].relative * std::fabs(a.values[f]));
+            CHECK(std::isfinite(value) && std::fabs(value - reconstructed) <= band + 1e-5 * std::fabs(value));
+        }
+    }
+
+    // The heartbeat writes the constant stretch.
+    size_t beats = 0;
+    for (auto&& p : points)
+        beats += p.timestamp > samples[410].timestamp && p.timestamp < samples[590].timestamp;
+    CHECK(beats >= 5);
+    CHECK(unwritten > n / 2);
+    return points.size();
+}
+
+//! Every suppressed sample is reconstructed within its band in both
+//! modes, and the swinging door needs fewer points.
+static void testDeadband()
+{
+    const size_t plain = checkDeadband(false);
+    const size_t door = checkDeadband(true);
+    CHECK(door < plain);
+}
+
+//! Fields of rollup lines by window start and channel.
+typedef std::map<long long, std::map<std::string, std::map<std::string, double> > > RollupFields;
+
+//! Parses the lines of a rollup tier, checking the measurement.
+static RollupFields parseRollup(const std::string& lines, const std::string& measurement)
+{
+    RollupFields windows;
+    size_t begin = 0, end;
+    while ((end = lines.find('\n', begin)) != std::string::npos)
+    {
+        // measurement,channel=name field=value,... timestamp
+        const std::string line = lines.substr(begin, end - begin);
+        begin = end + 1;
+        const size_t tag = line.find(",channel="), space = line.find(' '), last = line.rfind(' ');
+        CHECK(line.substr(0, tag) == measurement);
+        const std::string channel = line.substr(tag + 9, space - tag - 9);
+        std::map<std::string, double>& fields = windows[std::stoll(line.substr(last + 1))][channel];
+        CHECK(fields.empty());
+        const std::string list = line.substr(space + 1, last - space - 1) + ",";
+        for (size_t f = 0, comma; (comma = list.find(',', f)) != std::string::npos; f = comma + 1)
+        {
+            const size_t equals = list.find('=', f);
+            fields[list.substr(f, equals - f)] = std::strtod(list.c_str() + equals + 1, nullptr);
+        }
+    }
+    return windows;
+}
+
+//! Results across window boundaries and a gap are aggregated per window
+//! and tier, each window is written once when it is complete and stamped
+//! with its start, and empty windows are not written.
+static void testRollup()
+{
+    const std::vector<Rollup::Tier> tiers { { 10, "r10", "" }, { 60, "r60", "" }, { 300, "r300", "" } };
+    const char* channels[] = { "voltage", "frequency", "c1", "c2" };
+    Rollup rollup(tiers, { "c1", "c2" });
+    const long long second = 1000000000LL;
+    const long long base = 1476799800LL * second;
+
+    // Reference aggregates by tier, window start and channel.
+    struct Expected
+    {
+        double min, max, integral, last, seconds;
+    };
+    std::map<long long, std::vector<Expected> > expected[3];
+    std::string lines[3];
+    long long newest = 0;
+    BlockResult result;
+    result.power.resize(2);
+    for (unsigned int k = 0; k < 640; ++k)
+    {
+        // Every 2 s, on window boundaries too, with a gap from 400 s to 700 s.
+        result.timestamp = base + (36 + 2 * k) * second;
+        if (result.timestamp > base + 400 * second && result.timestamp < base + 700 * second)
+            continue;
+        const double seconds = 1.0 + k % 3 * 0.5;
+        result.vRMS = 230.f + k % 7 * 0.25f;
+        result.frequency = 50.f + k % 5 * 0.01f;
+        result.power[0] = 100.f + k;
+        result.power[1] = -50.f + 3.f * (k % 4);
+        const double values[] = { result.vRMS, result.frequency, result.power[0], result.power[1] };
+        for (unsigned int t = 0; t < 3; ++t)
+        {
+            // A window ends at the first multiple of its length at or after the timestamp.
+            const long long length = tiers[t].interval * second;
+            std::vector<Expected>& window = expected[t][(result.timestamp - 1) / length * length];
+            if (window.empty())
+                window.assign(4, Expected { HUGE_VAL, -HUGE_VAL, 0.0, 0.0, 0.0 });
+            for (unsigned int c = 0; c < 4; ++c)
+            {
+                window[c].min = std::min(window[c].min, values[c]);
+                window[c].max = std::max(window[c].max, values[c]);
+                window[c].integral += values[c] * seconds;
+                window[c].last = values[c];
+                window[c].seconds += seconds;
+            }
+        }
+        rollup.add(result, seconds);
+        for (unsigned int t = 0; t < 3; ++t)
+            lines[t].append(rollup.lines(t).data(), rollup.lines(t).size());
+        newest = result.timestamp;
+    }
+
+    // A window of the first tier is complete once a later result arrived,
+    // one of a further tier once a window of the tier before ended with or
+    // after it.
+    long long complete = newest - 1;
+    for (unsigned int t = 0; t < 3; ++t)
+    {
+        const long long length = tiers[t].interval * second;
+        const RollupFields windows = parseRollup(lines[t], tiers[t].measurement);
+        long long closed = 0;
+        size_t count = 0;
+        for (auto&& w : expected[t])
+        {
+            const long long end = w.first + length;
+            const auto written = windows.find(w.first);
+            CHECK((written != windows.end()) == (end <= complete));
+            if (written == windows.end())
+                continue;
+            closed = std::max(closed, end);
+            ++count;
+            for (unsigned int c = 0; c < 4; ++c)
+            {
+                const auto channel = written->second.find(channels[c]);
+                CHECK(channel != written->second.end());
+                if (channel == written->second.end())
+                    continue;
+                const std::map<std::string, double>& fields = channel->second;
+                const Expected& e = w.second[c];
+                CHECK(fields.size() == (c < 2 ? 4u : 5u));
+                CHECK(fields.at("min") == e.min);
+                CHECK(fields.at("max") == e.max);
+                CHECK(fields.at("last") == e.last);
+                CHECK_NEAR(fields.at("mean"), e.integral / e.seconds, bound(1e-12, e.max));
+                if (c >= 2)
+                    CHECK_NEAR(fields.at("energy"), e.integral / 3600.0, bound(1e-12, e.integral / 3600.0));
+            }
+        }
+        // Nothing for the empty windows of the gap.
+        CHECK(windows.size() == count);
+        CHECK(count >= 3);
+        complete = closed;
+    }
+}
+
+//! Checks the records of a spool against the expected ones in order.
+static void checkSpool(Spool& spool, const std::deque<std::string>& expected)
+{
+    const char* data;
+    size_t size;
+    CHECK(spool.empty() == expected.empty());
+    CHECK(spool.front(data, size) == !expected.empty());
+    if (!expected.empty())
+        CHECK(std::string(data, size) == expected.front());
+}
+
+//! Records come out in order and intact across wraps of the ring and
+//! reopening, a full ring rejects records, a torn record is skipped and an
+//! unpublished record is ignored.
+static void testSpool()
+{
+    char path[] = "/tmp/powermon_spool_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    if (fd < 0)
+        return;
+    close(fd);
+    // Record headers are 8 bytes and records are padded to 8 bytes.
+    auto padded = [](size_t size) { return (8 + size + 7) & ~(size_t) 7; };
+    const size_t headerSize = 4096;
+
+    std::mt19937 random(5);
+    std::deque<std::string> expected;
+    std::unique_ptr<Spool> spool(new Spool(path, 8192));
+    CHECK(spool->capacity() == 4096);
+    unsigned int appended = 0;
+    for (unsigned int i = 0; i < 5000; ++i)
+    {
+        if (random() % 2)
+        {
+            std::string record(random() % 600, 'a' + i % 26);
+            record += std::to_string(i);
+            const bool ok = spool->append(record.data(), record.size());
+            // Only a full ring rejects records.
+            CHECK(ok || spool->used() + 2 * padded(record.size()) > spool->capacity());
+            if (ok)
+            {
+                expected.push_back(record);
+                ++appended;
+            }
+        }
+        else if (!expected.empty())
+        {
+            spool->pop();
+            expected.pop_front();
+        }
+        if (i % 97 == 0)
+        {
+            // An existing file keeps its size.
+            spool.reset();
+            spool.reset(new Spool(path, 65536));
+            CHECK(spool->capacity() == 4096);
+        }
+        checkSpool(*spool, expected);
+    }
+    CHECK(appended > 2000);
+    while (!expected.empty())
+    {
+        spool->pop();
+        expected.pop_front();
+    }
+    checkSpool(*spool, expected);
+    CHECK(spool->used() == 0);
+
+    // Reopening a file with a bad header starts over at the beginning.
+    auto restart = [&]()
+    {
+        spool.reset();
+        int f = open(path, O_RDWR);
+        CHECK(pwrite(f, "garbage!", 8, 0) == 8);
+        close(f);
+        spool.reset(new Spool(path, 8192));
+        checkSpool(*spool, std::deque<std::string>());
+    };
+
+    // Full segment: one slot is kept free. A record ending at the end of
+    // the segment wraps without a marker.
+    restart();
+    const std::string record(100, 'x');
+    while (spool->append(record.data(), record.size()))
+        expected.push_back(record);
+    CHECK(expected.size() == (spool->capacity() - 1) / padded(record.size()));
+    const std::string last(spool->capacity() - expected.size() * padded(record.size()) - 8, 'y');
+    CHECK(!spool->append(last.data(), last.size()));
+    spool->pop();
+    expected.pop_front();
+    CHECK(spool->append(last.data(), last.size()));
+    expected.push_back(last);
+    CHECK(!spool->append(record.data(), record.size()));
+    spool->pop();
+    expected.pop_front();
+    CHECK(spool->append(record.data(), record.size()));
+    expected.push_back(record);
+    while (!expected.empty())
+    {
+        checkSpool(*spool, expected);
+        spool->pop();
+        expected.pop_front();
+    }
+    checkSpool(*spool, expected);
+
+    // The second of three records is torn and an unpublished record is
+    // left behind the third.
+    restart();
+    const std::string records[] = { "first", "second record", "third" };
+    for (auto&& r : records)
+        CHECK(spool->append(r.data(), r.size()));
+    fd = open(path, O_RDWR);
+    const size_t second = headerSize + padded(records[0].size());
+    CHECK(pwrite(fd, "X", 1, second + 8 + 3) == 1);
+    const size_t end = second + padded(records[1].size()) + padded(records[2].size());
+    const uint32_t unpublished[2] = { 5, 0 };
+    CHECK(pwrite(fd, unpublished, sizeof(unpublished), end) == sizeof(unpublished));
+    close(fd);
+    spool.reset();
+    spool.reset(new Spool(path, 8192));
+    checkSpool(*spool, std::deque<std::string>(records, records + 1));
+    spool->pop();
+    checkSpool(*spool, std::deque<std::string>(records + 2, records + 3));
+    spool->pop();
+    checkSpool(*spool, std::deque<std::string>());
+    spool.reset();
+    unlink(path);
+}
+
+//! Test case.
+struct Test
+{
+    const char* name;       //!< Name to run it by.
+    void (*run)();          //!< Test function.
+};
+
+static const Test tests[] = {
+    { "line_protocol_allocations", testLineProtocolAllocations },
+    { "line_protocol_round_trip", testLineProtocolRoundTrip },
+    { "frequency_estimator", testFrequencyEstimator },
+    { "filter_bank", testFilterBank },
+    { "harmonics", testHarmonics },
+    { "fixed_point", testFixedPoint },
+    { "meter_kernels", testMeterKernels },
+    { "udp_transport", testUdpTransport },
+    { "frame_transport", testFrameTransport },
+    { "spool", testSpool },
+    { "deadband", testDeadband },
+    { "rollup", testRollup }
+};
+
+int main(int argc, char **argv)
+{
+    // Runs the named tests, all without arguments.
+    unsigned int failed = 0;
+    unsigned int run = 0;
+    for (auto&& test : tests)
+    {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i)
+            selected |= strcmp(argv[i], test.name) == 0;
+        if (!selected)
+            continue;
+        failures = 0;
+        test.run();
+        printf("%s %s\n", failures ? "FAIL" : "ok  ", test.name);
+        failed += failures ? 1 : 0;
+        run++;
+    }
+    if (run == 0)
+    {
+        fprintf(stderr, "No such test.\n");
+        return 1;
+    }
+    return failed ? 1 : 0;
+}
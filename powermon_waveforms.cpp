@@ -0,0 +1,127 @@
+/*
+ * powermon_waveforms.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "WaveformStream.h"
+
+using namespace PowerMonitor;
+
+// Example client of the waveform stream. Prints the RMS of every channel
+// of each block, or all samples as CSV.
+
+volatile sig_atomic_t terminate = 0;
+
+static void sighandler(int)
+{
+    terminate = 1;
+}
+
+int main(int argc, char **argv)
+{
+    bool csv = false;
+    std::string name = "/powermon";
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--csv") == 0)
+            csv = true;
+        else if (argv[i][0] == '/')
+            name = argv[i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [--csv] [/NAME]\n", argv[0]);
+            return 1;
+        }
+    }
+    signal(SIGINT, &sighandler);
+    signal(SIGTERM, &sighandler);
+
+    try
+    {
+        WaveformSubscriber stream(name);
+        const unsigned int channels = stream.channels();
+        // Poll about four times per block.
+        const useconds_t pause = 250000ULL * stream.capacity() / stream.sampleRate();
+
+        printf(csv ? "block,timestamp,sample" : "block,timestamp");
+        for (unsigned int c = 0; c < channels; ++c)
+            printf(",%s", stream.name(c).c_str());
+        printf("\n");
+
+        WaveformSubscriber::View view;
+        std::vector<double> rms(channels);
+        while (!terminate)
+        {
+            WaveformSubscriber::Status status = stream.next(view);
+            if (status == WaveformSubscriber::Empty)
+            {
+                if (stream.closed())
+                {
+                    fprintf(stderr, "Stream closed by the writer.\n");
+                    break;
+                }
+                usleep(pause);
+                continue;
+            }
+            if (status == WaveformSubscriber::Overrun)
+                fprintf(stderr, "Overrun, %llu blocks lost in total.\n", stream.lost());
+
+            // Work on the shared memory directly, then check it was not overwritten meanwhile.
+            if (csv)
+            {
+                std::string out;
+                char buffer[32];
+                for (size_t i = 0; i < view.count; ++i)
+                {
+                    snprintf(buffer, sizeof(buffer), "%llu,%lld,%zu", (unsigned long long) view.block,
+                            view.timestamp, i);
+                    out += buffer;
+                    for (unsigned int c = 0; c < channels; ++c)
+                    {
+                        snprintf(buffer, sizeof(buffer), ",%g", view.channel(c)[i]);
+                        out += buffer;
+                    }
+                    out += '\n';
+                }
+                if (stream.valid(view))
+                    fputs(out.c_str(), stdout);
+            }
+            else
+            {
+                for (unsigned int c = 0; c < channels; ++c)
+                {
+                    const float* x = view.channel(c);
+                    double squares = 0.0;
+                    for (size_t i = 0; i < view.count; ++i)
+                        squares += (double) x[i] * x[i];
+                    rms[c] = view.count ? std::sqrt(squares / view.count) : 0.0;
+                }
+                if (stream.valid(view))
+                {
+                    printf("%llu,%lld", (unsigned long long) view.block, view.timestamp);
+                    for (unsigned int c = 0; c < channels; ++c)
+                        printf(",%.3f", rms[c]);
+                    printf("\n");
+                }
+            }
+            if (!stream.valid(view))
+                fprintf(stderr, "Block %llu overwritten while reading.\n", (unsigned long long) view.block);
+            fflush(stdout);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}